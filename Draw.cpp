@@ -17,6 +17,12 @@
 #include <cmath>
 #include <TBox.h>
 #include <TLatex.h>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define EV_ERG 1.6e-12
 #define MP 1.672e-24
@@ -212,11 +218,103 @@ public:
         return false;
     }
 
+    // двоичный результат capture (binary=путь): заголовок ResultHeader и массивы подряд, см. ResultFile.h
+    bool readBinary(const std::string &fileName)
+    {
+        struct Header
+        {
+            char magic[8];
+            uint32_t nz, nr, method, flags, precision, cells;
+            uint64_t seed, particles;
+            double sigma, theta, z, r, normaN, nFlyby;
+        };
+        const uint32_t COUNTS = 1;
+        const uint32_t NI_2D = 2;
+        const uint32_t SPARSE = 4;
+
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Header))
+        {
+            close(fd);
+            return false;
+        }
+        void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            return false;
+
+        const char *data = static_cast<const char *>(map);
+        Header header;
+        memcpy(&header, data, sizeof(Header));
+        nz = header.nz;
+        nr = header.nr;
+        const size_t mesh = (size_t) nz*nr;
+        const size_t cells = (header.flags & SPARSE) ? header.cells : mesh;
+        const size_t nNi = (header.flags & NI_2D) ? mesh : nz;
+        const size_t indexSize = (header.flags & SPARSE) ? (cells*sizeof(uint32_t) + 7)/8*8 : 0;
+        const size_t capSize = (header.flags & COUNTS) ? sizeof(uint32_t) : sizeof(double);
+        const size_t size = sizeof(Header) + (nz + 1 + nr + 1 + nNi)*sizeof(double) + indexSize + cells*capSize + (cells + 7)/8;
+        if ((size_t) st.st_size < size)
+        {
+            munmap(map, st.st_size);
+            return false;
+        }
+
+        const double *p = reinterpret_cast<const double *>(data + sizeof(Header));
+        zArray.assign(p, p + nz + 1);
+        p += nz + 1;
+        rArray.assign(p, p + nr + 1);
+        p += nr + 1;
+        ni.assign(p, p + nNi);
+        p += nNi;
+
+        // при SPARSE записаны только ячейки из списка index, остальные нулевые
+        const uint32_t *index = (header.flags & SPARSE) ? reinterpret_cast<const uint32_t *>(p) : nullptr;
+        const char *capData = reinterpret_cast<const char *>(p) + indexSize;
+        const unsigned char *bits = reinterpret_cast<const unsigned char *>(capData + cells*capSize);
+        cap.assign(mesh, 0.);
+        lineCell.assign(mesh, false);
+        for (size_t k = 0; k < cells; k++)
+        {
+            const size_t cell = index ? index[k] : k;
+            if (cell >= mesh)
+                continue;
+            if (header.flags & COUNTS)
+                cap[cell] = (double) reinterpret_cast<const uint32_t *>(capData)[k] / header.particles;
+            else
+                cap[cell] = reinterpret_cast<const double *>(capData)[k];
+            lineCell[cell] = (bits[k >> 3] >> (k & 7)) & 1;
+        }
+
+        normaN = header.normaN;
+        theta = header.theta*M_PI/180.;
+        z0 = header.z;
+        r0 = header.r;
+        nFlyby = header.nFlyby*100.;
+
+        munmap(map, st.st_size);
+        return true;
+    }
+
     DrawMesh(std::string fileName) : colorMult(-1.), colorAdd(0.)
     {
         std::ifstream fin;
-        fin.open(fileName);
+        fin.open(fileName, std::ios::binary);
         error = false;
+        char magic[8] = {0};
+        if (fin.is_open() && fin.read(magic, sizeof(magic)) && std::string(magic, sizeof(magic)) == "CAPRES01")
+        {
+            fin.close();
+            error = !readBinary(fileName);
+            if (error)
+                std::cerr << "ошибка чтения двоичного результата " << fileName << "\n";
+            return;
+        }
+        fin.clear();
+        fin.seekg(0);
         if (fin.is_open()) 
         {
             std::string line;
@@ -301,20 +399,39 @@ public:
                 return;
             }
 
-            if (!readUntil(fin, "# 	ni"))
+            if (!readUntil(fin, "# 	ni", &line))
             {
                 std::cerr << "не удалось найти ni\n";
                 error = true;
                 fin.close();
                 return;
             }
-            ni.reserve(nz);
-            for (uint i = 0; i < nz; i++)
+            if (line.find("2d") != std::string::npos)
             {
-                char symbol;
-                double val;
-                fin >> symbol >> val;
-                ni.push_back(val);
+                // ni(z, r): строка на каждый iz
+                ni.reserve(nz*nr);
+                for (uint iz = 0; iz < nz; iz++)
+                {
+                    char symbol;
+                    fin >> symbol;
+                    for (uint ir = 0; ir < nr; ir++)
+                    {
+                        double val;
+                        fin >> val;
+                        ni.push_back(val);
+                    }
+                }
+            }
+            else
+            {
+                ni.reserve(nz);
+                for (uint i = 0; i < nz; i++)
+                {
+                    char symbol;
+                    double val;
+                    fin >> symbol >> val;
+                    ni.push_back(val);
+                }
             }
 
             if (fin.fail())
@@ -358,18 +475,41 @@ public:
             StringReader::getDoubleParameter(line, "# nFlyby=", nFlyby);
             std::getline(fin, line);
 
-            cap.reserve(nr*nz);
-            lineCell.reserve(nr*nz);
-
-            for (uint iz = 0; iz < nz; iz++)
+            if (fin.peek() == '#')
             {
-                for (uint ir = 0; ir < nr; ir++)
+                // output=sparse: строки iz ir nCap line - ячейки линии, а у пучка и ненулевые
+                // ячейки вне линии, поэтому ячейка линии берется из признака строки
+                std::getline(fin, line);
+                cap.assign(nr*nz, 0.);
+                lineCell.assign(nr*nz, false);
+                uint iz, ir;
+                double val;
+                bool onLine;
+                while (fin >> iz >> ir >> val >> onLine)
                 {
-                    double val;
-                    bool line;
-                    fin >> val >> line;
-                    cap.push_back(val);
-                    lineCell.push_back(line);
+                    if (iz < nz && ir < nr)
+                    {
+                        cap[iz*nr+ir] = val;
+                        lineCell[iz*nr+ir] = onLine;
+                    }
+                }
+                fin.clear();
+            }
+            else
+            {
+                cap.reserve(nr*nz);
+                lineCell.reserve(nr*nz);
+
+                for (uint iz = 0; iz < nz; iz++)
+                {
+                    for (uint ir = 0; ir < nr; ir++)
+                    {
+                        double val;
+                        bool line;
+                        fin >> val >> line;
+                        cap.push_back(val);
+                        lineCell.push_back(line);
+                    }
                 }
             }
 
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <random>
+
+#include "Counter.h"
+#include "CaptureTable.h"
+#include "Random.h"
+
+// скорость розыгрыша частиц (частиц/с) для каждого метода на большой сетке
+// и скорость генераторов случайных чисел внутри цикла розыгрыша
+// запуск: capture_bench [n] [particles]
+
+static std::string makeDeck(uint n, uint particles, const std::string &method)
+{
+    std::ostringstream deck;
+    deck << "normaN=1e13\n";
+    deck << "mesh\n";
+    deck << "\tz-axis\n\t\tarray " << n << "\n\t\t\tmin 0\n\t\t\tmax 100\n";
+    deck << "\tr-axis\n\t\tarray " << n << "\n\t\t\tmin 0\n\t\t\tmax 100\n";
+    deck << "\tni\n";
+    for (uint iz = 0; iz < n; iz++)
+        deck << "\t\t" << 1. + (iz % 7) << "\n";
+    deck << "mesh end\n";
+    deck << "count\n";
+    deck << "\tparticles=" << particles << "\n";
+    deck << "\tsigma=1e-16\n";
+    deck << "\ttheta=30\n";
+    deck << "\tmethod=" << method << "\n";
+    deck << "\tseed=1\n";
+    deck << "\tposition\n\t\tz 10.3\n\t\tr 50.7\n";
+    deck << "count end\n";
+    return deck.str();
+}
+
+template <class Uniform>
+static void benchGenerator(const std::string &name, const CaptureTable &table, uint particles, Uniform uniform)
+{
+    uiarray tally(table.size() + 1, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (uint it = 0; it < particles; it++)
+        tally[table.find(uniform())]++;
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << name << "\t" << particles / seconds << "\t" << tally[table.size()] << "\n";
+}
+
+int main(int argc, char** argv)
+{
+    uint n = argc > 1 ? std::stoul(argv[1]) : 2000;
+    uint particles = argc > 2 ? std::stoul(argv[2]) : 1000000;
+
+    const std::vector<std::string> methods = {"linear", "binary", "alias", "multinomial", "simd"};
+
+    std::cout << "# mesh " << n << "x" << n << ", particles " << particles << "\n";
+    std::cout << "# method       ns          particles/s\n";
+    for (const std::string &method : methods)
+    {
+        std::istringstream in(makeDeck(n, particles, method));
+        std::ostringstream out;
+        Counter counter(in, out);
+        if (!counter.isReadSuccess())
+        {
+            std::cerr << counter.getReader().getError();
+            return 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        counter.count();
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        std::cout << method << "\t" << counter.getReader().getNs() << "\t" << particles / seconds << "\n";
+    }
+
+    CaptureTable table;
+    table.build(darray(2*n, 1. / n));
+
+    std::cout << "#\n# generator    particles/s     flyby\n";
+    {
+        std::mt19937 gen(1);
+        std::uniform_real_distribution <> dist(0., 1.);
+        benchGenerator("mt19937", table, particles, [&]() { return dist(gen); });
+    }
+    {
+        std::mt19937_64 gen(1);
+        benchGenerator("mt19937_64", table, particles, [&]() { return std::generate_canonical<double, 53>(gen); });
+    }
+    {
+        Philox gen(1, 0);
+        benchGenerator("philox", table, particles, [&]() { return gen.uniform(); });
+    }
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+#include <memory>
+
+#include "Counter.h"
+#include "InputReader.h"
+
+// набор замеров на синтетических сетках n x n (равномерные и сгущающиеся к оси узлы,
+// несколько углов и оптических толщин линии): чтение колоды, построение линии инжекции,
+// частиц/с для каждого метода розыгрыша и скорость вывода результата.
+// результат - строки TSV "nz nr axis theta tau metric value unit", строки # - комментарии
+// запуск: capture_suite [quick|full] [particles] [threads]
+
+static const double LENGTH = 100.;
+// больше этого числа ячеек не считаются пучок и плотная текстовая таблица (nz*nr в памяти и в тексте)
+static const double DENSE_LIMIT = 4e6;
+
+struct Case
+{
+    uint n;
+    bool uniform;
+    double theta;
+    double tau; // оптическая толщина всей линии при среднем ni
+};
+
+static void writeAxis(std::ostream &deck, const char *name, const Case &c)
+{
+    deck << "\t" << name << "\n";
+    if (c.uniform)
+    {
+        deck << "\t\tarray " << c.n << "\n\t\t\tmin 0\n\t\t\tmax " << LENGTH << "\n";
+        return;
+    }
+    // узлы сгущаются к нулю как (i/n)^1.5
+    deck << "\t\tn " << c.n << "\n";
+    for (uint i = 0; i <= c.n; i++)
+        deck << "\t\t\t" << LENGTH*std::pow(static_cast<double>(i) / c.n, 1.5) << "\n";
+}
+
+static std::string makeDeck(const Case &c, uint particles, const std::string &method, const std::string &extra)
+{
+    std::ostringstream deck;
+    deck << std::setprecision(17);
+    deck << extra;
+    deck << "mesh\n";
+    writeAxis(deck, "z-axis", c);
+    writeAxis(deck, "r-axis", c);
+    deck << "\tni\n";
+    for (uint iz = 0; iz < c.n; iz++)
+        deck << "\t\t" << 1. + (iz % 7) << "\n";
+    deck << "mesh end\n";
+    deck << "count\n";
+    deck << "\tparticles=" << particles << "\n";
+    // среднее ni = 4, длина линии порядка LENGTH
+    deck << "\tsigma=" << c.tau / (4.*LENGTH) << "\n";
+    deck << "\ttheta=" << c.theta << "\n";
+    deck << "\tmethod=" << method << "\n";
+    deck << "\tseed=1\n";
+    deck << "\tposition\n\t\tz " << 0.05*LENGTH << "\n\t\tr " << 0.95*LENGTH << "\n";
+    deck << "count end\n";
+    return deck.str();
+}
+
+// среднее время вызова f, повторяется не меньше minSeconds
+template <class F>
+static double measure(F f, double minSeconds=0.2)
+{
+    uint reps = 0;
+    double seconds = 0.;
+    auto start = std::chrono::steady_clock::now();
+    do
+    {
+        f();
+        reps++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < minSeconds);
+    return seconds / reps;
+}
+
+static void report(const Case &c, const std::string &metric, double value, const std::string &unit)
+{
+    std::cout << c.n << "\t" << c.n << "\t" << (c.uniform ? "uniform" : "graded") << "\t" << c.theta << "\t" << c.tau
+              << "\t" << metric << "\t" << value << "\t" << unit << "\n";
+    std::cout.flush();
+}
+
+static void runCase(const Case &c, uint particles, uint threads)
+{
+    const double cells = static_cast<double>(c.n)*c.n;
+    const std::string deck = makeDeck(c, particles, "binary", "");
+
+    // чтение колоды вместе с линией инжекции, линия отдельно через setCountPoint
+    std::unique_ptr<InputReader> reader;
+    const double read = measure([&]() {
+        std::istringstream in(deck);
+        reader.reset(new InputReader(in));
+    });
+    if (!reader->isWork())
+    {
+        std::cerr << "# " << c.n << " theta=" << c.theta << ": " << reader->getError();
+        return;
+    }
+    const CountPoint point = {c.theta, 0.05*LENGTH, 0.95*LENGTH, c.tau / (4.*LENGTH), particles};
+    const double line = measure([&]() { reader->setCountPoint(point); });
+    report(c, "read_deck", read, "s");
+    report(c, "read_deck_rate", deck.size() / read / 1e6, "MB/s");
+    report(c, "injection_line", line, "s");
+    report(c, "line_cells", reader->getNs(), "cells");
+
+    const std::vector<std::string> methods = {"linear", "binary", "alias", "multinomial", "simd", "beam"};
+    for (const std::string &method : methods)
+    {
+        const bool beam = method == "beam";
+        if (beam && cells > DENSE_LIMIT)
+            continue;
+        // linear проходит линию от начала, число частиц ограничено по длине линии
+        uint n = particles;
+        if (method == "linear")
+            n = std::min<double>(particles, std::max(1000., 2e8 / reader->getNs()));
+
+        std::string text = makeDeck(c, n, beam ? "binary" : method, "");
+        if (beam)
+            text.insert(text.find("\tseed=1\n"), "\twidth=1\n\tdivergence=1\n");
+        std::istringstream in(text);
+        InputReader methodReader(in);
+        methodReader.setThreads(threads);
+        std::ostringstream out;
+        Counter counter(std::move(methodReader), out);
+        const double seconds = measure([&]() { counter.count(); });
+        report(c, "sample_" + method, n / seconds, "particles/s");
+    }
+
+    // вывод результата: текстовая таблица, список ячеек линии и двоичный файл
+    const std::string binaryPath = "capture_suite.bin";
+    std::vector<std::pair<std::string, std::string>> outputs = {{"output_sparse", "output=sparse\nbinary=" + binaryPath + "\n"}};
+    if (cells <= DENSE_LIMIT)
+        outputs.insert(outputs.begin(), {"output_dense", "binary=" + binaryPath + "\n"});
+    for (const auto &output : outputs)
+    {
+        std::istringstream in(makeDeck(c, particles, "binary", output.second));
+        std::ostringstream text;
+        Counter counter(InputReader(in), text);
+        counter.count();
+        size_t bytes = 0;
+        const double print = measure([&]() {
+            text.str("");
+            counter.printResult();
+            bytes = text.str().size();
+        });
+        const double binary = measure([&]() { counter.writeBinary(); });
+        std::ifstream written(binaryPath, std::ios::binary | std::ios::ate);
+        const double binaryBytes = written.tellg();
+        report(c, output.first + "_text", bytes / print / 1e6, "MB/s");
+        report(c, output.first + "_binary", binaryBytes / binary / 1e6, "MB/s");
+    }
+    std::remove(binaryPath.c_str());
+}
+
+int main(int argc, char** argv)
+{
+    const std::string mode = argc > 1 ? argv[1] : "quick";
+    const uint particles = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    const uint threads = argc > 3 ? std::stoul(argv[3]) : 1;
+    if (mode != "quick" && mode != "full")
+    {
+        std::cerr << "capture_suite [quick|full] [particles] [threads]\n";
+        return 1;
+    }
+
+    std::vector<uint> sizes = {10, 100, 1000};
+    if (mode == "full")
+        sizes.push_back(10000);
+    const std::vector<double> angles = {10., 30., 60.};
+    const std::vector<double> taus = {0.1, 5.};
+
+    std::cout << "# capture_suite " << mode << ", particles " << particles << ", threads " << threads << "\n";
+    std::cout << "# nz\tnr\taxis\ttheta\ttau\tmetric\tvalue\tunit\n";
+    for (const uint n : sizes)
+    {
+        for (const bool uniform : {true, false})
+        {
+            for (const double theta : angles)
+            {
+                for (const double tau : taus)
+                    runCase({n, uniform, theta, tau}, particles, threads);
+            }
+        }
+    }
+
+    return 0;
+}
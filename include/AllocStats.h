@@ -0,0 +1,21 @@
+#ifndef __ALLOC_STATS_H__
+#define __ALLOC_STATS_H__
+
+#include <cstdint>
+
+// учет выделений памяти для TimeProfiler: при сборке с CAPTURE_ALLOC_STATS
+// (cmake -DCAPTURE_ALLOC_STATS=ON) operator new считает выделения и байты в каждом потоке,
+// без него счетчики нулевые и enabled() == false
+struct AllocStats
+{
+    uint64_t count;
+    uint64_t bytes;
+
+    static bool enabled();
+    // выделения текущего потока с его начала
+    static AllocStats thread();
+    // пиковый RSS процесса в байтах (getrusage, ru_maxrss), 0 если неизвестен
+    static double peakRss();
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef __BYTE_WRITER_H__
+#define __BYTE_WRITER_H__
+
+#include <vector>
+#include <deque>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// вывод байтов через собственный буфер: буфер отдается в ostream крупными блоками,
+// при async - фоновым потоком записи
+class ByteWriter
+{
+private:
+    std::ostream &os;
+
+    // фоновая запись: заполненные буферы ждут в очереди
+    const bool async;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable empty;
+    std::deque<std::vector<char>> queue;
+    bool writing;
+    bool done;
+
+    void writeLoop();
+
+protected:
+    const size_t capacity;
+    std::vector<char> buffer;
+
+    void reserve(size_t n)
+    {
+        if (buffer.size() + n > capacity)
+            flush();
+    }
+
+public:
+    ByteWriter(std::ostream &os, bool async=false, size_t capacity=1 << 20);
+    ByteWriter(const ByteWriter &)=delete;
+    ByteWriter & operator=(const ByteWriter &)=delete;
+
+    void write(const char *s, size_t n);
+
+    // отдать буфер в ostream (при async - в очередь фонового потока)
+    void flush();
+    // flush и дождаться, пока все записано в ostream
+    void sync();
+
+    ~ByteWriter();
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef __CAPTURE_TABLE_H__
+#define __CAPTURE_TABLE_H__
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+typedef std::vector<double> darray;
+typedef std::vector<unsigned> uiarray;
+typedef unsigned uint;
+
+// таблица вероятности захвата вдоль линии инжекции, строится один раз на запуск
+class CaptureTable
+{
+private:
+    darray cdf; // cdf[is] = 1 - exp(-tau(is)), tau(is) - оптическая толщина до конца ячейки is
+    darray cond; // cond[is] = 1 - exp(-dtau[is]), вероятность захвата в ячейке is при условии что до нее частица долетела
+    darray tau; // tau(is)
+
+    // таблица Уолкера на ns+1 исход, последний исход - пролет
+    darray aliasProb;
+    uiarray alias;
+
+public:
+    CaptureTable() {}
+
+    void build(const darray &dtau); // dtau[is] - оптическая толщина ячейки is
+    void buildAlias();
+
+    uint size() const { return cdf.size(); }
+    const darray & getCdf() const { return cdf; }
+    double probability(uint is) const { return is == 0 ? cdf[0] : cdf[is] - cdf[is-1]; }
+    double conditional(uint is) const { return cond[is]; }
+    double flyby() const { return cdf.empty() ? 1. : 1. - cdf.back(); }
+
+    // доля хорды ячейки is до точки захвата: по gamma, которым find выбрал ячейку is,
+    // или по равномерному u, если ячейка выбрана без обратной функции
+    double depth(uint is, double gamma) const
+    {
+        const double before = is == 0 ? 0. : tau[is-1];
+        return clampDepth((-log1p(-gamma) - before) / (tau[is] - before));
+    }
+    double depthUniform(uint is, double u) const
+    {
+        const double before = is == 0 ? 0. : tau[is-1];
+        return clampDepth(-log1p(-u*cond[is]) / (tau[is] - before));
+    }
+    static double clampDepth(double x) { return x > 0. ? (x < 1. ? x : 1.) : 0.; }
+
+    // номер ячейки захвата, size() если частица пролетела
+    uint find(double gamma) const
+    {
+        return std::upper_bound(cdf.begin(), cdf.end(), gamma) - cdf.begin();
+    }
+
+    uint findLinear(double gamma) const
+    {
+        uint is = 0;
+        while (is < cdf.size() && cdf[is] <= gamma)
+            is++;
+        return is;
+    }
+
+    uint findAlias(double gamma) const
+    {
+        double x = gamma*aliasProb.size();
+        uint is = static_cast<uint>(x);
+        if (is >= aliasProb.size())
+            is = aliasProb.size() - 1;
+        return x - is < aliasProb[is] ? is : alias[is];
+    }
+};
+
+#endif
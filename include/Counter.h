@@ -2,8 +2,18 @@
 #define __COUNTER_H__
 
 #include <vector>
+#include <memory>
+#include <unordered_map>
 
 #include "InputReader.h"
+#include "CaptureTable.h"
+#include "SimdSampler.h"
+#include "TimeProfiler.h"
+#include "Parallel.h"
+#include "Random.h"
+#include "ResultFile.h"
+#include "TextWriter.h"
+#include "EventDump.h"
 
 typedef std::vector<double> darray;
 typedef std::vector<unsigned> uiarray;
@@ -15,45 +25,202 @@ private:
 
     const InputReader reader;
     std::ostream &os;
+    mutable TextWriter out; // текст результата, TimeProfiler пишется прямо в os
     const uint nz;
     const uint nr;
-    const darray &ni;
-    const darray &zArray;
-    const darray &rArray;
+    const DoubleArray &ni;
+    const DoubleArray &zArray;
+    const DoubleArray &rArray;
     const uint nParticles;
     const double sigma;
     const double theta;
 
     const darray &sArray;
     const uint ns;
+    // гистограммы по номеру ячейки на линии (ns элементов), иначе по всей сетке nz*nr:
+    // частицы пучка и квадратура попадают и в ячейки вне линии
+    const bool sparse;
 
     const std::pair<double, double> &position;
+    // размер гистограммы только у той, что нужна методу: nCap - розыгрыш,
+    // nCapExact - analytic и quadrature, а при deviation и розыгрыш для сравнения
     uiarray nCap;
     uint nFlyby;
 
+    CaptureTable table;
+    SimdSampler simd;
+
+    darray nCapExact; // точная доля захваченных в ячейке
+    double nFlybyExact;
+
+    // частицы делятся на порции фиксированного размера, у каждой порции свой поток Philox,
+    // поэтому результат при заданном seed не зависит от числа потоков
+    static const uint CHUNK = 1u << 16;
+    // запас в конце частной гистограммы потока, чтобы соседние гистограммы не делили кэш-линию
+    static const uint PAD = 64 / sizeof(uint);
+    // до этого числа ячеек сетки частицы пучка копятся в плотные гистограммы потоков (4 МБ)
+    static const uint BEAM_DENSE = 1u << 20;
+
+    unsigned long long seed;
+    const bool printProfile; // печатать TimeProfiler при удалении
+    // точки захвата пишет только счет из колоды: events вместе с sweep и инжекторами InputReader не принимает
+    const bool dumpEvents;
+    std::unique_ptr<EventDump> events;
+
+    // текущая компонента пучка: сечение, число частиц и номер потока Philox
+    double runSigma;
+    uint runParticles;
+    uint runStream;
+
+    // результаты по компонентам, если их больше одной
+    std::vector<Component> components;
+    uiarray componentParticles;
+    std::vector<uiarray> componentCap;
+    uiarray componentFlyby;
+    std::vector<darray> componentExact;
+    darray componentFlybyExact;
+
+    void init();
     void clearPrevious();
+    void buildCaptureTable();
+    uint64_t stream(uint chunk) const { return (static_cast<uint64_t>(runStream) << 32) | chunk; }
+    Philox generator(uint chunk) const { return Philox(seed, stream(chunk)); }
+    uiarray splitParticles() const;
+    void countComponent();
+    void printComponent(uint ic) const;
+    void sampleMultinomial();
+    void computeExact();
+    void computeQuadrature();
+    void printDeviation() const;
+
+    // kernel(gen, n, tally, buffer) разыгрывает n частиц порции в частную гистограмму потока tally
+    // (копия empty, создается при первой порции потока) и точки захвата порции в buffer,
+    // если он enabled(); возвращает гистограммы потоков, у потоков без порций пустые
+    template <class Tally, class Kernel>
+    std::vector<Tally> sampleThreads(const Tally &empty, Kernel kernel)
+    {
+        TimeProfiler t_sample("time sample " + (reader.isBeam() ? std::string("beam") : InputReader::methodName(reader.method)));
+        // в uint64_t: при числе частиц около UINT_MAX сумма и chunk*CHUNK переполняют uint
+        const uint nChunks = static_cast<uint>((static_cast<uint64_t>(runParticles) + CHUNK - 1) / CHUNK);
+        const uint nThreads = std::min(Parallel::threads(reader.nThreads), nChunks);
+        std::vector<Tally> tallies(nThreads);
+        std::vector<EventBuffer> buffers(nThreads, EventBuffer(events.get()));
+        if (events)
+            events->startRun();
+
+        Parallel::run(nChunks, nThreads, [&](uint chunk, uint thread) {
+            Tally &tally = tallies[thread];
+            if (tally.empty())
+                tally = empty;
+
+            TimeProfiler t_chunk("time chunk");
+            EventBuffer &buffer = buffers[thread];
+            if (buffer.enabled())
+                buffer.begin(seed, chunk, stream(chunk));
+            Philox gen = generator(chunk);
+            const uint n = static_cast<uint>(std::min<uint64_t>(CHUNK, runParticles - static_cast<uint64_t>(chunk)*CHUNK));
+            kernel(gen, n, tally, buffer);
+            buffer.end();
+            TimeProfiler::addUnits(n, "particle");
+        });
+        TimeProfiler::addUnits(runParticles, "particle");
+        return tallies;
+    }
+
+    // то же с плотными гистограммами из nTally элементов, возвращает их сумму
+    template <class Kernel>
+    uiarray sampleChunks(uint nTally, Kernel kernel)
+    {
+        const std::vector<uiarray> tallies = sampleThreads(uiarray(nTally + PAD, 0), kernel);
+        uiarray total(nTally, 0);
+        for (const uiarray & tally : tallies)
+        {
+            if (tally.empty())
+                continue;
+            for (uint i = 0; i < nTally; i++)
+                total[i] += tally[i];
+        }
+        return total;
+    }
+
+    // номер ячейки is линии в гистограмме nCap
+    uint lineTally(uint is) const { return sparse ? is : reader.index[is].first*nr + reader.index[is].second; }
+    // гистограмма по номеру ячейки на линии, элемент ns - пролет
+    void addLineTally(const uiarray &tally);
+    // карта захвата, value(i) - доля в элементе i гистограммы; при output=sparse строки iz ir value
+    template <class Value>
+    void printMap(Value value) const;
+
+    // точка захвата на глубине depth (доля хорды) в ячейке is линии инжекции
+    void addLineEvent(EventBuffer &buffer, uint is, double depth) const
+    {
+        const double t = reader.lineStart[is] + depth*sArray[is];
+        buffer.add(reader.lineEntry.first + t*reader.lineDirection.first, reader.lineEntry.second + t*reader.lineDirection.second,
+                   reader.index[is].first*nr + reader.index[is].second);
+    }
+
+    // find(gamma) - ячейка захвата; точка внутри ячейки по тому же gamma, если invert, иначе по своему u
+    template <class Find>
+    void sample(Find find, bool invert)
+    {
+        addLineTally(sampleChunks(ns + 1, [&](Philox &gen, uint n, uiarray &tally, EventBuffer &buffer) {
+            if (!buffer.enabled())
+            {
+                for (uint it = 0; it < n; it++)
+                    tally[find(gen.uniform())]++;
+                return;
+            }
+            for (uint it = 0; it < n; it++)
+            {
+                const double gamma = gen.uniform();
+                const uint is = find(gamma);
+                tally[is]++;
+                if (is < ns && buffer.keep())
+                    addLineEvent(buffer, is, invert ? table.depth(is, gamma) : table.depthUniform(is, buffer.uniform()));
+            }
+        }));
+    }
+
+    void sampleSimd();
+    void sampleBeam();
 
 public:
     Counter(std::istream &in=std::cin, std::ostream &os=std::cout);
+    Counter(InputReader reader, std::ostream &os, bool printProfile=false);
     void count();
     
     double getSigma() const { return sigma; }
     uint getNParticles() const { return nParticles; }
     uint getNz() const { return nz; }
     uint getNFlyply() const { return nFlyby; }
-    const darray & getZArray() const { return zArray; }
-    const darray & getNi() const { return ni; }
+    unsigned long long getSeed() const { return seed; }
+    const DoubleArray & getZArray() const { return zArray; }
+    const DoubleArray & getRArray() const { return rArray; }
+    const DoubleArray & getNi() const { return ni; }
     const uiarray & getNCap() const { return nCap; }
 
 
-    double getnCap(uint index) const { return ((double) nCap[index]) / nParticles; }
-    double getnFlyby() const { return ((double) nFlyby) / nParticles; }
+    bool isExact() const { return reader.isExact(); }
+    bool isSparse() const { return sparse; }
+    // число элементов гистограммы и номер ячейки iz*nr+ir элемента i
+    uint tallySize() const { return sparse ? ns : nz*nr; }
+    uint cellIndex(uint i) const { return sparse ? reader.index[i].first*nr + reader.index[i].second : i; }
+    double getnCap(uint i) const { return isExact() ? nCapExact[i] : ((double) nCap[i]) / nParticles; }
+    double getnFlyby() const { return isExact() ? nFlybyExact : ((double) nFlyby) / nParticles; }
+    double getnCapExact(uint i) const { return nCapExact[i]; }
+    double getnFlybyExact() const { return nFlybyExact; }
 
     bool isReadSuccess() const { return reader.work; }
-    const InputReader getReader() const { return reader; }
+    const InputReader & getReader() const { return reader; }
 
     void printStartInfo() const;
     void printResult() const;
+    // дописать весь отложенный текст в поток, перед тем как писать в него напрямую
+    void syncOutput() const { out.sync(); }
+    // заголовок двоичного результата по параметрам count
+    ResultHeader resultHeader() const;
+    // двоичный результат в reader.getBinaryPath(), false при ошибке записи
+    bool writeBinary() const;
 
     ~Counter();
 
@@ -0,0 +1,73 @@
+#ifndef __DECK_READER_H__
+#define __DECK_READER_H__
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstring>
+#include <cstddef>
+
+typedef std::vector<double> darray;
+typedef unsigned uint;
+
+// участок буфера колоды без копирования
+struct Span
+{
+    const char *ptr;
+    size_t length;
+
+    bool operator==(const char *word) const { return std::strlen(word) == length && std::memcmp(ptr, word, length) == 0; }
+    bool operator!=(const char *word) const { return !(*this == word); }
+    std::string str() const { return std::string(ptr, length); }
+};
+
+// колода читается в память целиком и разбирается за один проход:
+// текущая строка режется на слова по пробелам, табуляциям и '=',
+// параметр "key value" или "key=value" ищется среди слов строки без выделения памяти
+class DeckReader
+{
+private:
+    std::string buffer;
+    const char *cursor;
+    const char *end;
+    const char *lineBegin;
+    const char *lineEnd;
+    std::vector<Span> tokens; // слова текущей строки, память переиспользуется
+    uint &numberLine; // номер текущей строки для сообщений об ошибках
+
+    void tokenize();
+    // индекс слова после key или tokens.size()
+    size_t find(const char *key) const;
+
+public:
+    DeckReader(std::istream &in, uint &numberLine);
+
+    // следующая строка, false в конце колоды
+    bool next();
+    // следующая строка с данными, пустые строки и комментарии # пропускаются
+    bool skip();
+
+    bool isEmpty() const { return tokens.empty(); }
+    size_t size() const { return tokens.size(); }
+    const Span & token(size_t i) const { return tokens[i]; }
+    bool has(const char *word) const;
+    // строка "name ..." кроме "name end"
+    bool isBlock(const char *name) const { return !tokens.empty() && tokens[0] == name && !isEnd(name); }
+    bool isEnd(const char *name) const { return tokens.size() > 1 && tokens[0] == name && tokens[1] == "end"; }
+
+    bool getDouble(const char *key, double &val) const;
+    bool getUnsigned(const char *key, uint &val) const;
+    bool getUnsignedLL(const char *key, unsigned long long &val) const;
+    bool getWord(const char *key, std::string &val) const;
+
+    static bool toDouble(const Span &word, double &val);
+    static bool toUnsigned(const Span &word, uint &val);
+
+    // count чисел начиная со следующей строки колоды
+    bool readValues(darray &values, size_t count);
+    // числа из [p, end) через strtod, # комментирует остаток строки;
+    // false при постороннем символе, буфер должен заканчиваться не цифрой или нулем
+    static bool parseValues(const char *p, const char *end, darray &values, size_t count);
+};
+
+#endif
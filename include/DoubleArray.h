@@ -0,0 +1,52 @@
+#ifndef __DOUBLE_ARRAY_H__
+#define __DOUBLE_ARRAY_H__
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstddef>
+
+#include "MappedFile.h"
+
+typedef std::vector<double> darray;
+
+// неизменяемый массив double: свой вектор или участок отображенного файла без копирования,
+// копии массива разделяют данные
+class DoubleArray
+{
+private:
+    std::shared_ptr<const void> owner;
+    const double *ptr;
+    size_t length;
+
+public:
+    // двоичный файл массива: 8 байт MAGIC, число элементов uint64 и сами double, все little-endian
+    static constexpr const char *MAGIC = "CAPDBL01";
+    static const size_t HEADER = 16;
+
+    DoubleArray() : ptr(nullptr), length(0) {}
+    DoubleArray(darray &&values);
+
+    // true если файл начинается с MAGIC
+    static bool isBinary(const MappedFile &file);
+    // отобразить двоичный файл массива, при ошибке false и текст в error
+    static bool map(const std::shared_ptr<MappedFile> &file, DoubleArray &array, std::string &error);
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const double * data() const { return ptr; }
+    const double * begin() const { return ptr; }
+    const double * end() const { return ptr + length; }
+    const double & front() const { return ptr[0]; }
+    const double & back() const { return ptr[length-1]; }
+    const double & operator[](size_t i) const { return ptr[i]; }
+
+    void clear()
+    {
+        owner.reset();
+        ptr = nullptr;
+        length = 0;
+    }
+};
+
+#endif
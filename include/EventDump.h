@@ -0,0 +1,151 @@
+#ifndef __EVENT_DUMP_H__
+#define __EVENT_DUMP_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <cstdint>
+
+#include "ByteWriter.h"
+#include "Random.h"
+
+typedef unsigned uint;
+
+// точка захвата частицы, cell = iz*nr+ir
+struct CaptureEvent
+{
+    float z;
+    float r;
+    uint32_t cell;
+};
+
+// заголовок файла событий, за ним events записей CaptureEvent, все little-endian
+struct EventHeader
+{
+    char magic[8];
+    uint32_t nz;
+    uint32_t nr;
+    uint32_t stride; // записано каждое stride-е событие порции
+    uint32_t recordSize;
+    uint64_t limit; // не больше limit событий (0 - без ограничения)
+    uint64_t seed;
+    uint64_t events;
+};
+
+// параметры дампа событий из строки events блока count
+struct EventOptions
+{
+    std::string path;
+    uint stride;
+    unsigned long long limit;
+    bool async;
+};
+
+// файл событий захвата, общий для потоков розыгрыша:
+// без limit события пишутся в порядке порций (при async фоновым потоком), порции, готовые раньше
+// предыдущих, ждут своей очереди; с limit хранится одна выборка из limit событий с наименьшим ключом
+// хеша (номер потока Philox, номер события). в обоих случаях при заданном seed файл не зависит от числа потоков
+class EventDump
+{
+public:
+    typedef std::pair<uint64_t, CaptureEvent> Keyed;
+
+private:
+    const EventOptions options;
+    std::ofstream file;
+    std::unique_ptr<ByteWriter> writer;
+    std::mutex mutex;
+    EventHeader header;
+    uint nextChunk;
+    std::map<uint, std::vector<CaptureEvent>> pending;
+    std::vector<Keyed> reservoir; // max-куча по ключу
+    std::atomic<uint64_t> threshold; // ключ вершины полной выборки, события с большим ключом в нее не попадут
+
+    void write(const std::vector<CaptureEvent> &events);
+
+public:
+    static constexpr const char *MAGIC = "CAPEVT01";
+
+    EventDump(const EventOptions &options, uint nz, uint nr, unsigned long long seed);
+    EventDump(const EventDump &)=delete;
+    EventDump & operator=(const EventDump &)=delete;
+
+    bool isOpen() const { return file.is_open(); }
+    uint getStride() const { return options.stride; }
+    unsigned long long getLimit() const { return options.limit; }
+    uint64_t getThreshold() const { return threshold.load(std::memory_order_relaxed); }
+
+    // новый розыгрыш (компонента пучка), его порции нумеруются с нуля
+    void startRun();
+    // события порции chunk, без limit
+    void commit(uint chunk, std::vector<CaptureEvent> &events);
+    // кандидаты в выборку limit
+    void offer(const std::vector<Keyed> &events);
+    // дописать выборку и число событий в заголовок, false при ошибке записи
+    bool close();
+
+    static bool heapLess(const Keyed &a, const Keyed &b) { return a.first < b.first; }
+
+    ~EventDump() { close(); }
+};
+
+// события порции, которую разыгрывает поток
+class EventBuffer
+{
+private:
+    EventDump *dump;
+    uint chunk;
+    uint64_t stream;
+    uint skip; // событий до следующего сохраняемого
+    uint64_t index; // номер сохраненного события порции, ключ выборки limit
+    Philox gen; // положение внутри ячейки для методов без обратной функции
+    std::vector<CaptureEvent> events;
+    std::vector<EventDump::Keyed> reservoir; // не больше limit событий порции, max-куча по ключу
+
+    static uint64_t hash(uint64_t x)
+    {
+        // splitmix64
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    void push(const CaptureEvent &event);
+
+public:
+    EventBuffer(EventDump *dump=nullptr) : dump(dump), chunk(0), stream(0), skip(0), index(0) {}
+
+    bool enabled() const { return dump != nullptr; }
+    // начало порции chunk, stream - ее номер потока Philox
+    void begin(unsigned long long seed, uint chunk0, uint64_t stream0)
+    {
+        chunk = chunk0;
+        stream = stream0;
+        skip = 0;
+        index = 0;
+        gen = Philox(seed, stream0 | (1ull << 63));
+    }
+    double uniform() { return gen.uniform(); }
+
+    // очередное событие порции, false если оно отброшено прореживанием stride
+    bool keep()
+    {
+        if (skip > 0)
+        {
+            skip--;
+            return false;
+        }
+        skip = dump->getStride() - 1;
+        return true;
+    }
+    void add(double z, double r, uint cell) { push({static_cast<float>(z), static_cast<float>(r), cell}); }
+    // конец порции: отдать ее события в файл
+    void end();
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef __GAUSS_HERMITE_H__
+#define __GAUSS_HERMITE_H__
+
+#include <vector>
+
+typedef std::vector<double> darray;
+typedef unsigned uint;
+
+// узлы и веса квадратуры Гаусса-Эрмита для стандартного нормального распределения:
+// E[f(x)] ~ sum w[i]*f(x[i]), sum w[i] = 1
+class GaussHermite
+{
+public:
+    static void nodes(uint n, darray &x, darray &w);
+    virtual ~GaussHermite()=0;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __INJECTORS_H__
+#define __INJECTORS_H__
+
+#include <ostream>
+
+#include "InputReader.h"
+
+// несколько инжекторов из блока count: линии строятся и разыгрываются параллельно,
+// печатается суммарная карта захвата (доли, взвешенные по weight) и карта каждого инжектора
+class Injectors
+{
+private:
+    const InputReader &reader;
+    const unsigned long long seed;
+    std::ostream &os;
+
+public:
+    Injectors(const InputReader &reader, unsigned long long seed, std::ostream &os) : reader(reader), seed(seed), os(os) {}
+
+    void run();
+};
+
+#endif
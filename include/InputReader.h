@@ -14,12 +14,41 @@
 #include <list>
 #include <unordered_map>
 
-#include "StringReader.h"
+#include "DeckReader.h"
+#include "LineTracer.h"
+#include "DoubleArray.h"
+#include "EventDump.h"
 
 typedef std::vector<double> darray;
 typedef std::vector<unsigned> uiarray;
 typedef unsigned uint;
 
+// точка сканирования параметров count, theta в градусах
+struct CountPoint
+{
+    double theta;
+    double z;
+    double r;
+    double sigma;
+    uint particles;
+};
+
+// инжектор из блока count: своя точка, угол (в градусах), сечение и вес в суммарной карте
+struct Injector
+{
+    CountPoint point;
+    double weight;
+};
+
+// компонента пучка (E, E/2, E/3): доля частиц и свое сечение
+struct Component
+{
+    double fraction;
+    double sigma;
+};
+
+enum class CountMethod { linear, binary, alias, multinomial, analytic, simd, quadrature }; // способ розыгрыша ячейки захвата
+
 class InputReader
 {
 private:
@@ -29,10 +58,18 @@ private:
     std::string error_message;
 
     uint precision;
-
-    darray zArray;
-    darray rArray;
-    darray ni;
+    std::string binaryPath; // двоичный файл результата, пусто - только текст
+    std::string tracePath; // трасса блоков TimeProfiler в формате Chrome trace event, пусто - без трассы
+    bool perfCounters; // perf=on: счетчики perf_event в профиле
+    bool sparseOutput; // output=sparse: в результате только ячейки линии строками iz ir nCap line
+    bool asyncOutput; // writer=async: текст пишется фоновым потоком
+
+    DoubleArray zArray;
+    DoubleArray rArray;
+    bool zUniform;
+    bool rUniform;
+    DoubleArray ni; // nz значений или nz*nr в порядке iz*nr+ir, как nCap
+    bool ni2d;
     std::vector <bool> lineCell;
     uint nz;
     uint nr;
@@ -40,59 +77,56 @@ private:
     double sigma;
     double theta;
     std::pair<double, double> position;
+    CountMethod method;
+    bool deviation; // печатать отклонение Монте-Карло от точного решения
+    uint nThreads; // 0 - все доступные ядра
+    bool hasThreads; // threads указан в колоде
+    bool hasSeed;
+    unsigned long long seed;
+    double width; // стандартное отклонение смещения поперек пучка
+    double divergence; // стандартное отклонение угла
+    uint nodes; // число узлов квадратуры по ширине и по углу
+
+    // значения сканирования sweep, пустой список - значение из count
+    darray sweepTheta;
+    darray sweepZ;
+    darray sweepR;
+    darray sweepSigma;
+    darray sweepParticles;
+
+    std::vector<Injector> injectors;
+    std::vector<Component> components;
+    EventOptions events; // events file=...: дамп точек захвата, пустой path - без дампа
 
 
     darray sArray;
     std::vector <std::pair<uint, uint>> index;
     uint ns = 0;
+    // линия инжекции входит в сетку в lineEntry и идет по lineDirection,
+    // ячейка is начинается на расстоянии lineStart[is] от входа
+    std::pair<double, double> lineEntry;
+    std::pair<double, double> lineDirection;
+    darray lineStart;
 
     double normaDensity;
 
-    uint countSpace(std::string line) const;
-
-    std::istream & getline(std::istream &in, std::string &line, bool formatLine=false, bool ignoreEqual=false) 
-    {
-        numberLine++;
-        std::getline(in, line);
-        if (formatLine)
-            line = StringReader::formatLine(line);
-        if (ignoreEqual)
-            std::replace(line.begin(), line.end(), '=', ' ');
-        return in;
-    }
-    void skip(std::istream &in, std::string &line, bool ignoreEqual=false);
-    bool isComment(const std::string &line) const 
-    {
-        if (line.empty())
-            return true;
-
-        uint i = 0;
-        while (line[i] == ' ' || line[i] == '\t') 
-        {
-            i++;
-            if (i == line.size())
-                return false;
-        }
-        return line[i] == '#'; 
-    }
-
-    std::string readWord(std::string line) 
-    {
-        std::istringstream iss(line);
-        std::string word;
-        iss >> word;
-        return word;
-    }
-
     void errorMessage(std::string error);
     void errorConfigConstNumberPar(std::string part1, const std::vector<std::string> PAR_NAMES, const bool *array, const uint N_STEP);
 
-    bool isLine(const std::string &line, const std::string &name) const { return line.find(name) != std::string::npos && line.find(name + " end") == std::string::npos; } 
-
-    bool readPosition(std::istream &in, std::pair<double, double> &p);
-    bool readAxis(std::istream &in, darray &axis, uint &size, const std::string &name);
-    bool readMesh(std::istream &in);
-    bool readCount(std::istream &in);
+    bool readPosition(DeckReader &deck, std::pair<double, double> &p);
+    // массив из текстового или двоичного (DoubleArray::MAGIC) файла, count == 0 - все значения
+    bool readArrayFile(const std::string &path, DoubleArray &array, size_t count);
+    bool readAxis(DeckReader &deck, DoubleArray &axis, uint &size, bool &uniform, const std::string &name);
+    bool readMesh(DeckReader &deck);
+    bool readDensity(DeckReader &deck);
+    bool readCount(DeckReader &deck);
+    bool readMethod(const DeckReader &deck);
+    bool readOutput(const DeckReader &deck);
+    bool readPerf(const DeckReader &deck);
+    bool readSweep(DeckReader &deck);
+    bool readInjector(DeckReader &deck);
+    bool readComponent(const DeckReader &deck);
+    bool readEvents(const DeckReader &deck);
 
     bool generateInjectionLine();
 
@@ -112,10 +146,6 @@ private:
         array = test | array;
     }
 
-
-    bool traceLine(int step, uint &iz0, uint &ir0, double sinTheta, double cosTheta, double z0, double r0, std::vector <std::pair<std::pair<uint, uint>, double>> &temp,
-                   bool (*condition) (uint iz0, uint ir0, uint nz, uint nr)    );
-
 public:
     
     InputReader(std::istream &in=std::cin);
@@ -123,6 +153,39 @@ public:
     bool isWork() const { return work; }
     const std::string getError() const { return error_message; } 
     uint getPrecision() const { return precision; }
+    const std::string & getBinaryPath() const { return binaryPath; }
+    const std::string & getTracePath() const { return tracePath; }
+    bool isPerfCounters() const { return perfCounters; }
+    bool isSparseOutput() const { return sparseOutput; }
+    bool isAsyncOutput() const { return asyncOutput; }
+    CountMethod getMethod() const { return method; }
+    uint getNs() const { return ns; }
+    bool isBeam() const { return width > 0. || divergence > 0.; } // каждая частица летит по своей прямой
+    bool hasSweep() const { return !(sweepTheta.empty() && sweepZ.empty() && sweepR.empty() && sweepSigma.empty() && sweepParticles.empty()); }
+    std::vector<CountPoint> getSweepPoints() const;
+    const std::vector<Injector> & getInjectors() const { return injectors; }
+    const EventOptions & getEvents() const { return events; }
+    // компоненты пучка, без них одна компонента с сечением sigma
+    std::vector<Component> getComponents() const { return components.empty() ? std::vector<Component>{{1., sigma}} : components; }
+    bool isLineCell(uint index) const { return lineCell[index]; }
+    bool setCountPoint(const CountPoint &point); // заменить параметры count и перестроить линию инжекции
+    void setThreads(uint threads) { nThreads = threads; }
+    void setSeed(unsigned long long seed0) { hasSeed = true; seed = seed0; }
+    uint getThreads() const { return nThreads; }
+    bool isThreadsSet() const { return hasThreads; }
+    // убрать линию инжекции и значения sweep, чтобы копии для точек сканирования их не тянули
+    void clearLine();
+    double density(uint iz, uint ir) const { return ni2d ? ni[iz*nr+ir] : ni[iz]; }
+    bool isDensity2d() const { return ni2d; }
+    uint getNz() const { return nz; }
+    uint getNr() const { return nr; }
+
+    bool isExact() const { return method == CountMethod::analytic || method == CountMethod::quadrature; }
+    const darray & getSArray() const { return sArray; }
+    const std::vector<std::pair<uint, uint>> & getIndex() const { return index; }
+    LineTracer getTracer() const { return LineTracer(zArray, rArray, zUniform, rUniform); }
+
+    static std::string methodName(CountMethod method);
 
 };
 
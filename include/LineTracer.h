@@ -0,0 +1,98 @@
+#ifndef __LINE_TRACER_H__
+#define __LINE_TRACER_H__
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include "DoubleArray.h"
+
+typedef std::vector<double> darray;
+typedef unsigned uint;
+
+// обход ячеек неравномерной сетки z, r вдоль прямой (Amanatides, Woo 1987):
+// ячейки выдаются сразу в порядке движения пучка, на шаг одно сравнение и одно деление
+class LineTracer
+{
+private:
+    const DoubleArray &zArray;
+    const DoubleArray &rArray;
+    const bool zUniform; // равномерная сетка, поиск ячейки за O(1)
+    const bool rUniform;
+
+    // ячейка, в которой находится x при движении в направлении d,
+    // на границе выбирается ячейка, в которую прямая входит
+    static uint locate(const DoubleArray &axis, bool uniform, double x, double d);
+    // параметр t пересечения следующей границы ячейки i по оси
+    static double boundary(const DoubleArray &axis, uint i, double x0, double d)
+    {
+        if (d > 0.)
+            return (axis[i+1] - x0) / d;
+        if (d < 0.)
+            return (axis[i] - x0) / d;
+        return std::numeric_limits<double>::infinity();
+    }
+
+public:
+    LineTracer(const DoubleArray &zArray, const DoubleArray &rArray, bool zUniform=false, bool rUniform=false) :
+        zArray(zArray), rArray(rArray), zUniform(zUniform), rUniform(rUniform) {}
+
+    // отрезок [tmin, tmax] прямой внутри сетки, trace начинает обход с tmin
+    bool clip(double z0, double r0, double dz, double dr, double &tmin, double &tmax) const;
+    // ячейка [z1, z2) x [r1, r2), содержащая точку
+    bool findCell(double z, double r, uint &iz, uint &ir) const;
+
+    // z = z0 + t*dz, r = r0 + t*dr, (dz, dr) - единичный вектор;
+    // visit(iz, ir, l) для каждой пересеченной ячейки, l - длина хорды в ячейке,
+    // обход прекращается когда visit возвращает false.
+    // возвращает false если прямая не пересекает сетку
+    template <class Visit>
+    bool trace(double z0, double r0, double dz, double dr, Visit visit) const
+    {
+        double t;
+        double tmax;
+        if (!clip(z0, r0, dz, dr, t, tmax))
+            return false;
+
+        const uint nz = zArray.size() - 1;
+        const uint nr = rArray.size() - 1;
+        uint iz = locate(zArray, zUniform, z0 + t*dz, dz);
+        uint ir = locate(rArray, rUniform, r0 + t*dr, dr);
+        double tz = boundary(zArray, iz, z0, dz);
+        double tr = boundary(rArray, ir, r0, dr);
+
+        // хорды короче этого считаются касанием угла ячейки
+        const double eps = 1e-12*(tmax - t);
+        while (true)
+        {
+            const double tNext = std::min(std::min(tz, tr), tmax);
+            if (tNext - t > eps && !visit(iz, ir, tNext - t))
+                break;
+            if (tNext >= tmax)
+                break;
+
+            // при попадании в угол шаг делается сразу по обеим осям
+            const bool stepZ = tz <= tr;
+            const bool stepR = tr <= tz;
+            if (stepZ)
+            {
+                if ((dz > 0. && iz+1 == nz) || (dz < 0. && iz == 0))
+                    break;
+                iz = dz > 0. ? iz+1 : iz-1;
+                tz = boundary(zArray, iz, z0, dz);
+            }
+            if (stepR)
+            {
+                if ((dr > 0. && ir+1 == nr) || (dr < 0. && ir == 0))
+                    break;
+                ir = dr > 0. ? ir+1 : ir-1;
+                tr = boundary(rArray, ir, r0, dr);
+            }
+            t = tNext;
+        }
+
+        return true;
+    }
+};
+
+#endif
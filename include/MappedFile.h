@@ -0,0 +1,30 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+// файл, отображенный в память только для чтения
+class MappedFile
+{
+private:
+    const char *ptr;
+    size_t length;
+
+    MappedFile(const char *ptr, size_t length) : ptr(ptr), length(length) {}
+
+public:
+    MappedFile(const MappedFile &)=delete;
+    MappedFile & operator=(const MappedFile &)=delete;
+
+    // nullptr если файл не удалось открыть или отобразить
+    static std::shared_ptr<MappedFile> open(const std::string &path);
+
+    const char * data() const { return ptr; }
+    size_t size() const { return length; }
+
+    ~MappedFile();
+};
+
+#endif
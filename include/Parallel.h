@@ -0,0 +1,61 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "TimeProfiler.h"
+
+typedef unsigned uint;
+
+struct Parallel
+{
+    // число потоков: 0 - все доступные ядра
+    static uint threads(uint nThreads)
+    {
+        if (nThreads == 0)
+            nThreads = std::thread::hardware_concurrency();
+        return nThreads == 0 ? 1 : nThreads;
+    }
+
+    // выполнить job(ijob, ithread) для ijob = 0..nJobs-1 на nThreads потоках,
+    // задачи раздаются динамически, ithread - номер потока для частных данных
+    template <class Job>
+    static void run(uint nJobs, uint nThreads, Job job)
+    {
+        nThreads = std::min(threads(nThreads), nJobs);
+        if (nThreads <= 1)
+        {
+            for (uint ijob = 0; ijob < nJobs; ijob++)
+            {
+                TimeProfiler::Tag tag("job", ijob);
+                job(ijob, 0);
+            }
+            return;
+        }
+
+        // блоки TimeProfiler в задачах вложены в блок вызвавшего потока, у событий трассы метка job
+        const TimeProfiler::Context context = TimeProfiler::context();
+        std::atomic<uint> next(0);
+        auto worker = [&](uint ithread) {
+            TimeProfiler::Worker profile(context, ithread);
+            for (uint ijob = next++; ijob < nJobs; ijob = next++)
+            {
+                TimeProfiler::Tag tag("job", ijob);
+                job(ijob, ithread);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(nThreads-1);
+        for (uint ithread = 1; ithread < nThreads; ithread++)
+            pool.emplace_back(worker, ithread);
+        worker(0);
+        for (std::thread & t : pool)
+            t.join();
+    }
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __PERF_COUNTERS_H__
+#define __PERF_COUNTERS_H__
+
+#include <string>
+#include <cstdint>
+
+// аппаратные счетчики текущего потока через perf_event_open (Linux, только user space):
+// счетчики открываются в потоке при первом чтении одной группой (ведущий - первый открытый, обычно cycles),
+// поэтому все они считают в одни и те же интервалы, а при мультиплексировании PMU приращения
+// масштабируются по времени enabled/running группы. счетчик, который ядро не дает открыть
+// (нет PMU в виртуальной машине, perf_event_paranoid, seccomp), недоступен и читается нулем
+class PerfCounters
+{
+public:
+    enum Event { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, N_EVENTS };
+
+    // сырые значения и время группы (нс): включена и реально на PMU
+    struct Values
+    {
+        uint64_t count[N_EVENTS];
+        uint64_t enabled;
+        uint64_t running;
+    };
+
+    static const char * name(Event event);
+
+    // открыть счетчики в текущем потоке, false если недоступны все, причина в error()
+    static bool probe();
+    static bool available(Event event);
+    static std::string error();
+
+    // текущие значения счетчиков потока
+    static void read(Values &values);
+    // приращения от start до end, масштабированные на долю времени, когда группа была на PMU
+    static void delta(const Values &start, const Values &end, uint64_t count[N_EVENTS]);
+};
+
+#endif
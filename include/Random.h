@@ -0,0 +1,88 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include <cstdint>
+#include <limits>
+
+// счетный генератор Philox4x32-10 (Salmon et al., SC'11):
+// число - шифр от счетчика, поэтому поток stream при одном seed независим от остальных
+// и может считаться в любом потоке без передачи состояния
+class Philox
+{
+private:
+    static constexpr uint32_t M0 = 0xD2511F53;
+    static constexpr uint32_t M1 = 0xCD9E8D57;
+    static constexpr uint32_t W0 = 0x9E3779B9;
+    static constexpr uint32_t W1 = 0xBB67AE85;
+
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t block[4];
+    unsigned used;
+
+    static void round(uint32_t *ctr, const uint32_t *k)
+    {
+        uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+        uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+        uint32_t c0 = static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ k[0];
+        uint32_t c2 = static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ k[1];
+        ctr[1] = static_cast<uint32_t>(p1);
+        ctr[3] = static_cast<uint32_t>(p0);
+        ctr[0] = c0;
+        ctr[2] = c2;
+    }
+
+    void generate()
+    {
+        uint32_t k[2] = {key[0], key[1]};
+        for (unsigned i = 0; i < 4; i++)
+            block[i] = counter[i];
+        for (unsigned r = 0; r < 10; r++)
+        {
+            if (r > 0)
+            {
+                k[0] += W0;
+                k[1] += W1;
+            }
+            round(block, k);
+        }
+
+        if (++counter[0] == 0)
+            ++counter[1];
+        used = 0;
+    }
+
+public:
+    typedef uint32_t result_type;
+
+    Philox(uint64_t seed=0, uint64_t stream=0)
+    {
+        key[0] = static_cast<uint32_t>(seed);
+        key[1] = static_cast<uint32_t>(seed >> 32);
+        counter[0] = 0;
+        counter[1] = 0;
+        counter[2] = static_cast<uint32_t>(stream);
+        counter[3] = static_cast<uint32_t>(stream >> 32);
+        used = 4;
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        if (used == 4)
+            generate();
+        return block[used++];
+    }
+
+    // равномерное на [0, 1) с 53 битами мантиссы
+    double uniform()
+    {
+        uint64_t hi = (*this)();
+        uint64_t lo = (*this)();
+        return ((hi << 21) ^ (lo >> 11)) * (1. / 9007199254740992.); // 2^-53
+    }
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef __RESULT_FILE_H__
+#define __RESULT_FILE_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <cstdint>
+
+#include "MappedFile.h"
+
+typedef unsigned uint;
+
+// заголовок двоичного файла результата, все поля little-endian
+struct ResultHeader
+{
+    char magic[8];
+    uint32_t nz;
+    uint32_t nr;
+    uint32_t method; // CountMethod
+    uint32_t flags;
+    uint32_t precision; // precision колоды для печати текстом
+    uint32_t cells; // число записанных ячеек при SPARSE
+    uint64_t seed;
+    uint64_t particles;
+    double sigma;
+    double theta; // в градусах
+    double z;
+    double r;
+    double normaN;
+    double nFlyby; // доля пролетевших частиц
+};
+
+// двоичный результат: заголовок, zArray[nz+1], rArray[nr+1], ni[nz] или ni[nz*nr],
+// при SPARSE номера ячеек iz*nr+ir uint32[cells] (дополненные до 8 байт),
+// nCap по ячейкам (uint32 числа захватов при COUNTS, иначе доли double)
+// и битовая карта ячеек линии инжекции, бит i%8 байта i/8.
+// без SPARSE записаны все nz*nr ячеек по порядку.
+// пишется в поток по секциям и читается через mmap без разбора
+class ResultFile
+{
+private:
+    std::shared_ptr<MappedFile> file;
+    const ResultHeader *head;
+    const double *z;
+    const double *r;
+    const double *niArray;
+    const uint32_t *cells;
+    const uint32_t *counts;
+    const double *fractions;
+    const uint8_t *lineBits;
+
+    // смещения массивов от начала файла, возвращает размер файла
+    static size_t layout(const ResultHeader &header, size_t offset[6]);
+
+public:
+    static constexpr const char *MAGIC = "CAPRES01";
+    enum Flags : uint32_t { COUNTS = 1, NI_2D = 2, SPARSE = 4 };
+
+    // cells - номера записанных ячеек при SPARSE, иначе nullptr;
+    // cap - uint32_t при COUNTS, иначе double; cap и lineCell по записанным ячейкам
+    static bool write(const std::string &path, const ResultHeader &header, const double *zArray, const double *rArray,
+                      const double *ni, const uint32_t *cells, const void *cap, const std::vector<bool> &lineCell);
+
+    ResultFile() : head(nullptr), z(nullptr), r(nullptr), niArray(nullptr), cells(nullptr), counts(nullptr), fractions(nullptr), lineBits(nullptr) {}
+
+    // при ошибке false и текст в error
+    bool open(const std::string &path, std::string &error);
+
+    const ResultHeader & header() const { return *head; }
+    uint getNz() const { return head->nz; }
+    uint getNr() const { return head->nr; }
+    const double * getZArray() const { return z; }
+    const double * getRArray() const { return r; }
+    bool isDensity2d() const { return head->flags & NI_2D; }
+    double density(uint iz, uint ir) const { return isDensity2d() ? niArray[iz*head->nr+ir] : niArray[iz]; }
+    bool isSparse() const { return head->flags & SPARSE; }
+    // записанные ячейки: k-я ячейка имеет номер cellIndex(k) = iz*nr+ir
+    uint getCells() const { return isSparse() ? head->cells : head->nz*head->nr; }
+    uint cellIndex(uint k) const { return cells ? cells[k] : k; }
+    double getnCap(uint k) const { return counts ? ((double) counts[k]) / head->particles : fractions[k]; }
+    bool isLineCell(uint k) const { return (lineBits[k >> 3] >> (k & 7)) & 1; }
+
+    // результат в том же виде, что и Counter::printResult: таблица или список iz ir nCap line при SPARSE
+    void print(std::ostream &os) const;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __SIMD_SAMPLER_H__
+#define __SIMD_SAMPLER_H__
+
+#include <vector>
+#include <string>
+
+typedef std::vector<double> darray;
+typedef unsigned uint;
+
+// поиск ячеек захвата сразу для блока равномерных чисел:
+// бинарный поиск без ветвлений по таблице cdf, дополненной до степени двойки,
+// шаги поиска выполняются векторно (AVX-512/AVX2/SSE2), набор инструкций выбирается при запуске
+class SimdSampler
+{
+public:
+    enum class Isa { scalar, sse2, avx2, avx512 };
+
+    static const uint BLOCK = 16; // равномерных чисел в блоке
+
+private:
+    darray table; // cdf и значения 2. до размера степени двойки
+    uint half; // первый шаг поиска
+    Isa isa;
+
+public:
+    SimdSampler() : half(0), isa(Isa::scalar) {}
+
+    static Isa detect();
+    static std::string isaName(Isa isa);
+
+    void build(const darray &cdf);
+    Isa getIsa() const { return isa; }
+
+    // cell[i] = число элементов cdf <= gamma[i], то есть номер ячейки захвата или ns для пролета
+    void find(const double *gamma, uint *cell, uint n) const;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include <ostream>
+#include <vector>
+
+#include "InputReader.h"
+
+// сканирование параметров count из блока sweep: сетка читается один раз,
+// точки считаются параллельно, результат точки пишется, как только записаны все предыдущие
+class Sweep
+{
+private:
+    const InputReader &reader;
+    const unsigned long long seed;
+    std::ostream &os;
+
+    std::string runPoint(const InputReader &base, uint ipoint, const CountPoint &point, uint threads) const;
+
+public:
+    Sweep(const InputReader &reader, unsigned long long seed, std::ostream &os) : reader(reader), seed(seed), os(os) {}
+
+    void run();
+};
+
+#endif
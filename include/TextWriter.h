@@ -0,0 +1,45 @@
+#ifndef __TEXT_WRITER_H__
+#define __TEXT_WRITER_H__
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+#include "ByteWriter.h"
+
+typedef unsigned uint;
+
+// текстовый вывод через буфер ByteWriter: double печатается как std::scientific с precision
+// (snprintf "%.*e", тот же текст что и у ostream), целые - без форматирования потока
+class TextWriter : public ByteWriter
+{
+private:
+    const int precision;
+
+public:
+    TextWriter(std::ostream &os, int precision, bool async=false, size_t capacity=1 << 20) :
+        ByteWriter(os, async, capacity), precision(precision) {}
+
+    TextWriter & operator<<(const char *s);
+    TextWriter & operator<<(const std::string &s) { return write(s.data(), s.size()); }
+    TextWriter & operator<<(char c)
+    {
+        reserve(1);
+        buffer.push_back(c);
+        return *this;
+    }
+    TextWriter & operator<<(bool value) { return *this << (value ? '1' : '0'); }
+    TextWriter & operator<<(int value);
+    TextWriter & operator<<(unsigned value) { return *this << static_cast<unsigned long long>(value); }
+    TextWriter & operator<<(unsigned long value) { return *this << static_cast<unsigned long long>(value); }
+    TextWriter & operator<<(unsigned long long value);
+    TextWriter & operator<<(double value);
+
+    TextWriter & write(const char *s, size_t n)
+    {
+        ByteWriter::write(s, n);
+        return *this;
+    }
+};
+
+#endif
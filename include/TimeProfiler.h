@@ -4,31 +4,136 @@
 #include <chrono>
 #include <string>
 #include <map>
+#include <vector>
 #include <iostream>
 #include <ostream>
 #include <iomanip>
+#include <mutex>
+#include <cstdint>
 
+#include "PerfCounters.h"
+#include "AllocStats.h"
+
+// профилировщик вложенных блоков: блок, открытый внутри другого, считается его потомком,
+// длительности копятся в буфере своего потока без блокировок и сливаются в общее дерево
+// при выходе потока или печати, общее дерево блокируется только при первом входе потока в блок.
+// для каждого блока печатаются число вызовов, сумма, среднее, min, max, p50 и p99, для блоков
+// из нескольких потоков еще и строки [slot N] по номеру потока в пуле Parallel::run (главный поток - 0):
+// это место в пуле, а не поток ОС, потоки последовательных и вложенных пулов с одним номером складываются.
+// при включенной трассе каждый блок еще и пишется событием на временной шкале,
+// при включенных счетчиках perf печатаются циклы, IPC и промахи блока и на единицу работы,
+// при сборке с CAPTURE_ALLOC_STATS - выделения памяти и пиковый RSS
 class TimeProfiler {
-    static std::map<std::string, double> timings;
-    std::chrono::time_point<std::chrono::high_resolution_clock> start;
-    std::string name;
-    
 public:
-    TimeProfiler(const std::string& name) : name(name) {
-        start = std::chrono::high_resolution_clock::now();
-    }
-    
-    ~TimeProfiler() {
-        auto end = std::chrono::high_resolution_clock::now();
-        double duration = std::chrono::duration<double, std::milli>(end - start).count();
-        timings[name] += duration;
-    }
-    
+    typedef std::chrono::steady_clock Clock;
+    struct Node; // узел дерева блоков, определен в TimerProfiler.cpp
+
+    // длительности одного блока в одном потоке (нс): квантили берутся из гистограммы
+    // по логарифму длительности, SUB корзин на удвоение, ошибка не больше 1/(2*SUB)
+    struct Stats
+    {
+        static const unsigned SUB = 8;
+        static const unsigned BUCKETS = 48*SUB; // до 2^48 нс
+
+        uint64_t calls;
+        double total;
+        double min;
+        double max;
+        std::vector<uint32_t> histogram;
+        // сумма приращений счетчиков perf и единиц работы (частиц, ячеек) за все вызовы
+        uint64_t counters[PerfCounters::N_EVENTS];
+        double units;
+        const char *unit;
+        // выделения потока внутри блока, пиковый RSS процесса на выходе и его рост за блок
+        uint64_t allocs;
+        uint64_t allocBytes;
+        double peakRss;
+        double rssGrowth;
+
+        Stats() : calls(0), total(0.), min(0.), max(0.), counters{0, 0, 0, 0}, units(0.), unit(nullptr),
+                  allocs(0), allocBytes(0), peakRss(0.), rssGrowth(0.) {}
+        void add(double ns);
+        void merge(const Stats &other);
+        double quantile(double q) const;
+    };
+
+    typedef std::vector<std::pair<const char *, long long>> Tags;
+
+    // открытый блок и метки потока, передаются потокам Parallel::run
+    struct Context
+    {
+        Node *node;
+        Tags tags;
+    };
+
+    // блоки потока Parallel::run вкладываются в блок, открытый вызвавшим потоком,
+    // и получают его метки, ithread - номер потока в статистике; счетчики perf всего потока
+    // добавляются к этому блоку, чтобы счетчики блока и на единицу работы учитывали все потоки
+    class Worker
+    {
+    private:
+        Node *saved;
+        unsigned savedThread;
+        Tags savedTags;
+        Node *node;
+        bool counted;
+        PerfCounters::Values startCounters;
+
+    public:
+        Worker(const Context &context, unsigned ithread);
+        Worker(const Worker &)=delete;
+        Worker & operator=(const Worker &)=delete;
+        ~Worker();
+    };
+
+    // метка key=value на время жизни объекта, попадает в args событий трассы (job, point, injector)
+    class Tag
+    {
+    public:
+        Tag(const char *key, long long value);
+        Tag(const Tag &)=delete;
+        Tag & operator=(const Tag &)=delete;
+        ~Tag();
+    };
+
+private:
+    Node *node;
+    Node *parent;
+    Clock::time_point start;
+    bool counted; // счетчики прочитаны на входе
+    PerfCounters::Values startCounters;
+    AllocStats startAlloc;
+    double startRss;
+
+public:
+    TimeProfiler(const std::string& name);
+    TimeProfiler(const TimeProfiler &)=delete;
+    TimeProfiler & operator=(const TimeProfiler &)=delete;
+    ~TimeProfiler();
+
+    // текущий блок и метки потока, для передачи в Worker
+    static Context context();
+
     static void print(std::ostream &os);
-    
-    static void reset() {
-        timings.clear();
-    }
+
+    // записывать каждый блок событием трассы, включается до чтения колоды
+    static void enableTrace();
+    // перестать записывать и отбросить накопленные события (колода без trace= или с ошибкой)
+    static void disableTrace();
+    static bool isTracing();
+    // трасса в формате Chrome trace event (chrome://tracing, ui.perfetto.dev):
+    // событие "X" на каждый блок с метками в args, false при ошибке записи; tid - дорожка потока:
+    // одновременно работающие потоки на разных дорожках, потоки следующих Parallel::run на тех же
+    static bool writeTrace(const std::string &path);
+
+    // читать счетчики perf на входе и выходе каждого блока, false если счетчики недоступны
+    static bool enableCounters();
+    // перестать читать счетчики, таблица счетчиков не печатается
+    static void disableCounters();
+    // n единиц работы unit (частиц, ячеек) в текущем блоке потока, для счетчиков на единицу
+    static void addUnits(double n, const char *unit);
+
+    static void reset();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,95 @@
+#include "AllocStats.h"
+
+#include <new>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#ifdef CAPTURE_ALLOC_STATS
+
+namespace {
+
+// без динамической инициализации, operator new может вызываться до main и при выходе потока
+thread_local uint64_t allocCount = 0;
+thread_local uint64_t allocBytes = 0;
+
+void * allocate(std::size_t size)
+{
+    allocCount++;
+    allocBytes += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+}
+
+void * operator new(std::size_t size)
+{
+    void *p = allocate(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+bool AllocStats::enabled()
+{
+    return true;
+}
+
+AllocStats AllocStats::thread()
+{
+    return AllocStats{allocCount, allocBytes};
+}
+
+#else
+
+bool AllocStats::enabled()
+{
+    return false;
+}
+
+AllocStats AllocStats::thread()
+{
+    return AllocStats{0, 0};
+}
+
+#endif
+
+double AllocStats::peakRss()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        return usage.ru_maxrss; // байты
+#else
+        return usage.ru_maxrss*1024.; // килобайты
+#endif
+    }
+#endif
+    return 0.;
+}
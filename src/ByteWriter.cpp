@@ -0,0 +1,88 @@
+#include "ByteWriter.h"
+
+ByteWriter::ByteWriter(std::ostream &os, bool async, size_t capacity) :
+    os(os), async(async), writing(false), done(false), capacity(capacity)
+{
+    buffer.reserve(capacity);
+    if (async)
+        thread = std::thread(&ByteWriter::writeLoop, this);
+}
+
+void ByteWriter::writeLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        ready.wait(lock, [this] { return done || !queue.empty(); });
+        if (queue.empty())
+            return;
+
+        std::vector<char> chunk = std::move(queue.front());
+        queue.pop_front();
+        writing = true;
+        lock.unlock();
+        os.write(chunk.data(), chunk.size());
+        lock.lock();
+        writing = false;
+        if (queue.empty())
+            empty.notify_all();
+    }
+}
+
+void ByteWriter::write(const char *s, size_t n)
+{
+    if (n > capacity)
+    {
+        flush();
+        sync();
+        os.write(s, n);
+        return;
+    }
+    reserve(n);
+    buffer.insert(buffer.end(), s, s + n);
+}
+
+void ByteWriter::flush()
+{
+    if (buffer.empty())
+        return;
+
+    if (!async)
+    {
+        os.write(buffer.data(), buffer.size());
+        buffer.clear();
+        return;
+    }
+
+    std::vector<char> next;
+    next.reserve(capacity);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(buffer));
+    }
+    ready.notify_one();
+    buffer = std::move(next);
+}
+
+void ByteWriter::sync()
+{
+    flush();
+    if (!async)
+        return;
+    std::unique_lock<std::mutex> lock(mutex);
+    empty.wait(lock, [this] { return queue.empty() && !writing; });
+}
+
+ByteWriter::~ByteWriter()
+{
+    flush();
+    if (async)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        ready.notify_one();
+        thread.join();
+    }
+}
@@ -0,0 +1,72 @@
+#include "CaptureTable.h"
+
+#include <cmath>
+
+void CaptureTable::build(const darray &dtau)
+{
+    cdf.clear();
+    cdf.reserve(dtau.size());
+    cond.clear();
+    cond.reserve(dtau.size());
+    tau.clear();
+    tau.reserve(dtau.size());
+
+    double integral = 0.;
+    for (const double & dt : dtau)
+    {
+        integral += dt;
+        cdf.push_back(1. - exp(-integral));
+        tau.push_back(integral);
+        cond.push_back(-expm1(-dt));
+    }
+
+    aliasProb.clear();
+    alias.clear();
+}
+
+void CaptureTable::buildAlias()
+{
+    // метод Воуза: вероятности масштабируются на число исходов и делятся на малые и большие
+    const uint n = cdf.size() + 1;
+    aliasProb.assign(n, 1.);
+    alias.resize(n);
+
+    darray scaled(n);
+    for (uint is = 0; is < n-1; is++)
+        scaled[is] = probability(is)*n;
+    scaled[n-1] = flyby()*n;
+
+    uiarray small;
+    uiarray large;
+    for (uint is = 0; is < n; is++)
+    {
+        alias[is] = is;
+        if (scaled[is] < 1.)
+            small.push_back(is);
+        else
+            large.push_back(is);
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        uint s = small.back();
+        uint l = large.back();
+        small.pop_back();
+
+        aliasProb[s] = scaled[s];
+        alias[s] = l;
+        scaled[l] -= 1. - scaled[s];
+
+        if (scaled[l] < 1.)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // остатки из-за ошибок округления имеют вероятность 1
+    for (const uint & is : small)
+        aliasProb[is] = 1.;
+    for (const uint & is : large)
+        aliasProb[is] = 1.;
+}
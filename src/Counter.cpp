@@ -2,9 +2,16 @@
 #include <cmath>
 #include <random>
 #include <iostream>
+#include <cstring>
+#include <algorithm>
 
 #include "TimeProfiler.h"
 #include "PhysicValues.h"
+#include "GaussHermite.h"
+
+const uint Counter::CHUNK;
+const uint Counter::PAD;
+const uint Counter::BEAM_DENSE;
 
 void Counter::clearPrevious()
 {
@@ -13,14 +20,50 @@ void Counter::clearPrevious()
         n0 = 0;
 }
 
-Counter::Counter(std::istream &in, std::ostream &os) : reader(in), os(os), nz(reader.nz), nr(reader.nr),
+Counter::Counter(std::istream &in, std::ostream &os) : reader(in), os(os), out(os, reader.precision, reader.asyncOutput), nz(reader.nz), nr(reader.nr),
+                                                        ni(reader.ni), zArray(reader.zArray), rArray(reader.rArray),
+                                                        nParticles(reader.nParticles), sigma(reader.sigma), theta(reader.theta), 
+                                                        sArray(reader.sArray), ns(reader.ns),
+                                                        sparse(!reader.isBeam() && reader.method != CountMethod::quadrature),
+                                                        position(reader.position), nCap(isExact() ? 0 : tallySize()),
+                                                        nCapExact(isExact() || reader.deviation ? tallySize() : 0), nFlybyExact(0.),
+                                                        printProfile(true), dumpEvents(!reader.events.path.empty())
+{
+    init();
+}
+
+Counter::Counter(InputReader reader0, std::ostream &os, bool printProfile) : reader(std::move(reader0)), os(os), out(os, reader.precision), nz(reader.nz), nr(reader.nr),
                                                         ni(reader.ni), zArray(reader.zArray), rArray(reader.rArray),
                                                         nParticles(reader.nParticles), sigma(reader.sigma), theta(reader.theta), 
                                                         sArray(reader.sArray), ns(reader.ns),
-                                                        position(reader.position), nCap(nz*nr) 
+                                                        sparse(!reader.isBeam() && reader.method != CountMethod::quadrature),
+                                                        position(reader.position), nCap(isExact() ? 0 : tallySize()),
+                                                        nCapExact(isExact() || reader.deviation ? tallySize() : 0), nFlybyExact(0.),
+                                                        printProfile(printProfile), dumpEvents(false)
+{
+    init();
+}
+
+void Counter::init()
 {
     os.precision(reader.precision);
     os << std::scientific;
+
+    seed = reader.seed;
+    if (!reader.hasSeed)
+    {
+        std::random_device rd;
+        seed = (static_cast<unsigned long long>(rd()) << 32) | rd();
+    }
+}
+
+void Counter::buildCaptureTable()
+{
+    TimeProfiler t_table("time capture table");
+    darray dtau(ns);
+    for (uint is = 0; is < ns; is++)
+        dtau[is] = sArray[is]*reader.density(reader.index[is].first, reader.index[is].second)*runSigma*reader.normaDensity;
+    table.build(dtau);
 }
 
 void Counter::count()
@@ -28,82 +71,578 @@ void Counter::count()
     TimeProfiler t_cout("time count full");
     if (!reader.work)
         return;
+
+    if (dumpEvents)
+    {
+        events.reset(new EventDump(reader.events, nz, nr, seed));
+        if (!events->isOpen())
+        {
+            std::cerr << "не удалось открыть файл событий " << reader.events.path << "\n";
+            events.reset();
+        }
+    }
+
+    TimeProfiler::addUnits(nParticles, "particle");
+    components = reader.getComponents();
+    componentParticles = splitParticles();
+    componentCap.clear();
+    componentFlyby.clear();
+    componentExact.clear();
+    componentFlybyExact.clear();
+
+    // геометрия линии общая, компоненты считаются последовательными проходами со своей таблицей
+    // захвата: каждый проход уже занимает все потоки порциями, а частицы поделены между
+    // компонентами, поэтому всего разыгрывается nParticles - столько же, сколько в одном проходе;
+    // общий проход потребовал бы таблицу и гистограмму каждой компоненты в каждом методе розыгрыша
+    for (uint ic = 0; ic < components.size(); ic++)
+    {
+        runSigma = components[ic].sigma;
+        runParticles = componentParticles[ic];
+        runStream = ic;
+        countComponent();
+        if (components.size() == 1)
+            break;
+
+        componentCap.push_back(nCap);
+        componentFlyby.push_back(nFlyby);
+        componentExact.push_back(nCapExact);
+        componentFlybyExact.push_back(nFlybyExact);
+    }
+    if (events)
+    {
+        TimeProfiler t_events("time write events");
+        if (!events->close())
+            std::cerr << "не удалось записать файл событий " << reader.events.path << "\n";
+        events.reset();
+    }
+    if (components.size() == 1)
+        return;
+
     clearPrevious();
+    for (double & n0 : nCapExact)
+        n0 = 0.;
+    nFlybyExact = 0.;
+    for (uint ic = 0; ic < components.size(); ic++)
+    {
+        for (uint i = 0; i < nCap.size(); i++)
+            nCap[i] += componentCap[ic][i];
+        for (uint i = 0; i < nCapExact.size(); i++)
+            nCapExact[i] += components[ic].fraction*componentExact[ic][i];
+        nFlyby += componentFlyby[ic];
+        nFlybyExact += components[ic].fraction*componentFlybyExact[ic];
+    }
+}
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution <> distGamma(0., 1.);
+uiarray Counter::splitParticles() const
+{
+    // число частиц компонент - одно полиномиальное распределение по долям,
+    // отдельный поток Philox не пересекается с потоками порций
+    uiarray particles(components.size(), 0);
+    Philox gen(seed, ~0ull);
+    uint left = nParticles;
+    double mass = 1.;
+    for (uint ic = 0; ic + 1 < components.size() && left > 0; ic++)
+    {
+        std::binomial_distribution<uint> dist(left, std::min(1., components[ic].fraction / mass));
+        particles[ic] = dist(gen);
+        left -= particles[ic];
+        mass -= components[ic].fraction;
+    }
+    particles.back() += left;
+    return particles;
+}
 
-    for (uint it = 0; it < nParticles; it++)
+void Counter::countComponent()
+{
+    clearPrevious();
+    buildCaptureTable();
+
+    if (reader.method == CountMethod::quadrature)
     {
-        double P1 = 0;
-        double P2 = 0;
-        bool found = false;
-        double gamma = distGamma(gen);
-        double integral = 0.;
-        for (uint is = 0; is < ns; is++)
+        computeQuadrature();
+        return;
+    }
+    if (isExact() || reader.deviation)
+        computeExact();
+    if (isExact())
+        return;
+
+    if (reader.isBeam())
+    {
+        sampleBeam();
+        return;
+    }
+
+    switch (reader.method)
+    {
+    case CountMethod::linear:
+        sample([this](double gamma) { return table.findLinear(gamma); }, true);
+        break;
+    case CountMethod::binary:
+        sample([this](double gamma) { return table.find(gamma); }, true);
+        break;
+    case CountMethod::alias:
+        table.buildAlias();
+        sample([this](double gamma) { return table.findAlias(gamma); }, false);
+        break;
+    case CountMethod::multinomial:
+        sampleMultinomial();
+        break;
+    case CountMethod::simd:
+        sampleSimd();
+        break;
+    case CountMethod::analytic:
+    case CountMethod::quadrature:
+        break;
+    }
+}
+
+void Counter::addLineTally(const uiarray &tally)
+{
+    for (uint is = 0; is < ns; is++)
+        nCap[lineTally(is)] += tally[is];
+    nFlyby += tally[ns];
+}
+
+void Counter::sampleSimd()
+{
+    simd.build(table.getCdf());
+    addLineTally(sampleChunks(ns + 1, [this](Philox &gen, uint n, uiarray &tally, EventBuffer &buffer) {
+        const uint BLOCK = SimdSampler::BLOCK;
+        double gamma[BLOCK];
+        uint cell[BLOCK];
+        for (uint it = 0; it < n; it += BLOCK)
         {
-            uint iz = reader.index[is].first;
-            uint ir = reader.index[is].second;
-            integral += sArray[is]*ni[iz]*sigma*reader.normaDensity;
-            P2 = 1. - exp(-integral);
+            const uint nBlock = std::min(BLOCK, n - it);
+            for (uint ib = 0; ib < nBlock; ib++)
+                gamma[ib] = gen.uniform();
+            simd.find(gamma, cell, nBlock);
+            // гистограмма обновляется после поиска всего блока
+            for (uint ib = 0; ib < nBlock; ib++)
+                tally[cell[ib]]++;
+            if (!buffer.enabled())
+                continue;
+            for (uint ib = 0; ib < nBlock; ib++)
+            {
+                if (cell[ib] < ns && buffer.keep())
+                    addLineEvent(buffer, cell[ib], table.depth(cell[ib], gamma[ib]));
+            }
+        }
+    }));
+}
+
+void Counter::sampleBeam()
+{
+    // каждая частица стартует со смещением поперек пучка и под своим углом (гауссовы распределения),
+    // длина пробега до захвата разыгрывается как оптическая толщина -ln(gamma)
+    // и набирается вдоль луча ячейка за ячейкой без вычисления экспонент
+    const LineTracer tracer = reader.getTracer();
+    darray mu(ni.size());
+    for (uint i = 0; i < ni.size(); i++)
+        mu[i] = ni[i]*runSigma*reader.normaDensity;
+    // для ni(z) индекс ячейки iz, для ni(z, r) iz*nr+ir
+    const uint strideZ = reader.ni2d ? nr : 1;
+    const uint strideR = reader.ni2d ? 1 : 0;
+
+    const uint nCells = nz*nr;
+    // threadTally - плотная гистограмма из nCells + 1 элементов или хеш-таблица по номеру ячейки
+    auto kernel = [&](Philox &gen, uint n, auto &threadTally, EventBuffer &buffer) {
+        for (uint it = 0; it < n; it++)
+        {
+            const double rho = sqrt(-2.*log(1. - gen.uniform()));
+            const double phi = 2.*M_PI*gen.uniform();
+            const double offset = reader.width*rho*cos(phi);
+            const double angle = theta + reader.divergence*rho*sin(phi);
+
+            const double z0 = position.first + offset*sin(theta);
+            const double r0 = position.second + offset*cos(theta);
+            const double dz = cos(angle);
+            const double dr = -sin(angle);
+            double tau = -log(1. - gen.uniform());
 
-            if ( (P1 < gamma && P2 > gamma))
+            uint cell = nCells;
+            double s = 0.; // путь от входа в сетку до начала текущей ячейки
+            tracer.trace(z0, r0, dz, dr, [&](uint iz, uint ir, double l) {
+                const double m = mu[iz*strideZ+ir*strideR];
+                if (tau < m*l)
+                {
+                    cell = iz*nr+ir;
+                    s += tau / m;
+                    return false;
+                }
+                tau -= m*l;
+                s += l;
+                return true;
+            });
+            threadTally[cell]++;
+
+            if (cell < nCells && buffer.enabled() && buffer.keep())
             {
-                nCap[iz*nr+ir]++;
-                found = true;
-                break;
+                double tEntry;
+                double tExit;
+                tracer.clip(z0, r0, dz, dr, tEntry, tExit);
+                buffer.add(z0 + (tEntry + s)*dz, r0 + (tEntry + s)*dr, cell);
             }
+        }
+    };
+
+    // на большой сетке плотная гистограмма на каждый поток не помещается в память,
+    // потоки копят только задетые ячейки, их не больше числа частиц потока
+    if (nCells <= BEAM_DENSE)
+    {
+        const uiarray tally = sampleChunks(nCells + 1, kernel);
+        for (uint i = 0; i < nCells; i++)
+            nCap[i] += tally[i];
+        nFlyby += tally[nCells];
+        return;
+    }
+    const std::vector<std::unordered_map<uint, uint>> tallies = sampleThreads(std::unordered_map<uint, uint>(), kernel);
+    for (const auto & tally : tallies)
+    {
+        for (const auto & it : tally)
+        {
+            if (it.first < nCells)
+                nCap[it.first] += it.second;
+            else
+                nFlyby += it.second;
+        }
+    }
+}
+
+void Counter::sampleMultinomial()
+{
+    TimeProfiler t_sample("time sample multinomial");
+    TimeProfiler::addUnits(runParticles, "particle");
+    Philox gen = generator(0);
+    // все частицы разыгрываются одним полиномиальным распределением:
+    // число захваченных в ячейке is - биномиальное от оставшихся частиц
+    // с условной вероятностью захвата при условии пролета ячеек до is
+    // точки захвата разыгрываются внутри ячейки по условному распределению своим потоком
+    EventBuffer buffer(events.get());
+    if (buffer.enabled())
+    {
+        events->startRun();
+        buffer.begin(seed, 0, stream(0));
+    }
+    uint left = runParticles;
+    for (uint is = 0; is < ns && left > 0; is++)
+    {
+        std::binomial_distribution<uint> distCap(left, table.conditional(is));
+        uint n0 = distCap(gen);
+
+        nCap[lineTally(is)] += n0;
+        left -= n0;
 
-            P1 = P2;
+        for (uint k = 0; buffer.enabled() && k < n0; k++)
+        {
+            if (buffer.keep())
+                addLineEvent(buffer, is, table.depthUniform(is, buffer.uniform()));
         }
+    }
+    buffer.end();
 
-        if (!found)
-            nFlyby++;
+    nFlyby = left;
+}
+
+void Counter::computeExact()
+{
+    TimeProfiler t_exact("time count analytic");
+    // доля захваченных в ячейке exp(-tau(is-1)) - exp(-tau(is))
+    for (double & n0 : nCapExact)
+        n0 = 0.;
+    for (uint is = 0; is < ns; is++)
+        nCapExact[lineTally(is)] += table.probability(is);
+    nFlybyExact = table.flyby();
+}
+
+void Counter::computeQuadrature()
+{
+    TimeProfiler t_quadrature("time count quadrature");
+    // осреднение точного захвата по гауссовым смещению и углу пучка:
+    // по каждому узлу строится своя линия инжекции и на ней считается аналитический захват
+    darray offset;
+    darray wOffset;
+    darray angle;
+    darray wAngle;
+    GaussHermite::nodes(reader.width > 0. ? reader.nodes : 1, offset, wOffset);
+    GaussHermite::nodes(reader.divergence > 0. ? reader.nodes : 1, angle, wAngle);
+
+    const LineTracer tracer = reader.getTracer();
+    for (double & n0 : nCapExact)
+        n0 = 0.;
+    nFlybyExact = 0.;
+
+    for (uint io = 0; io < offset.size(); io++)
+    {
+        const double z0 = position.first + reader.width*offset[io]*sin(theta);
+        const double r0 = position.second + reader.width*offset[io]*cos(theta);
+        for (uint ia = 0; ia < angle.size(); ia++)
+        {
+            const double w = wOffset[io]*wAngle[ia];
+            const double a = theta + reader.divergence*angle[ia];
+            double tau = 0.;
+            double survive = 1.;
+            tracer.trace(z0, r0, cos(a), -sin(a), [&](uint iz, uint ir, double l) {
+                tau += reader.density(iz, ir)*runSigma*reader.normaDensity*l;
+                const double next = exp(-tau);
+                nCapExact[iz*nr+ir] += w*(survive - next);
+                survive = next;
+                return true;
+            });
+            nFlybyExact += w*survive;
+        }
     }
 }
 
 void Counter::printStartInfo() const 
 {
-    os << "# precision=" << reader.precision << "\n";
-    os << "# normaN=" << reader.normaDensity << "\n";
-    os << "#\n";
-    os << "# mesh\n";
-    os << "# \tz-axis\n# \t\tn " << nz << "\n";
+    TimeProfiler t_print("time print input");
+    out << "# precision=" << reader.precision << "\n";
+    out << "# normaN=" << reader.normaDensity << "\n";
+    if (!reader.binaryPath.empty())
+        out << "# binary=" << reader.binaryPath << "\n";
+    if (!reader.tracePath.empty())
+        out << "# trace=" << reader.tracePath << "\n";
+    if (reader.perfCounters)
+        out << "# perf=on\n";
+    if (reader.sparseOutput)
+        out << "# output=sparse\n";
+    out << "#\n";
+    out << "# mesh\n";
+    out << "# \tz-axis\n# \t\tn " << nz << "\n";
     for (const double & z0 : zArray)
-        os << "# \t\t\t" << z0 << "\n";
-    os << "# \tr-axis\n# \t\tn " << nr << "\n";
+        out << "# \t\t\t" << z0 << "\n";
+    out << "# \tr-axis\n# \t\tn " << nr << "\n";
     for (const double & r0 : rArray)
-        os << "# \t\t\t" << r0 << "\n";
-    os << "# \tni\n";
-    for (const double & ni0 : ni)
-        os << "# \t\t" << ni0 << "\n";
+        out << "# \t\t\t" << r0 << "\n";
+    if (reader.ni2d)
+    {
+        out << "# \tni 2d\n";
+        for (uint iz = 0; iz < nz; iz++)
+        {
+            out << "# \t\t";
+            for (uint ir = 0; ir < nr; ir++)
+                out << ni[iz*nr+ir] << (ir+1 < nr ? " " : "\n");
+        }
+    }
+    else
+    {
+        out << "# \tni\n";
+        for (const double & ni0 : ni)
+            out << "# \t\t" << ni0 << "\n";
+    }
 
-    os << "#\n";
+    out << "#\n";
 
-    os << "# count\n";
-    os << "# \tparticles=" << nParticles << "\n";
-    os << "# \tsigma=" << sigma << "\n";
-    os << "# \ttheta=" << theta*180./M_PI << "\n";
-    os << "# \tposition\n";
-    os << "# \t\tz " << position.first << "\n# \t\tr " << position.second << "\n";
-    os << "#\n";
+    out << "# count\n";
+    out << "# \tparticles=" << nParticles << "\n";
+    out << "# \tsigma=" << sigma << "\n";
+    out << "# \ttheta=" << theta*180./M_PI << "\n";
+    out << "# \tposition\n";
+    out << "# \t\tz " << position.first << "\n# \t\tr " << position.second << "\n";
+    out << "# \tmethod=" << InputReader::methodName(reader.method) << "\n";
+    if (reader.method == CountMethod::simd)
+        out << "# \tisa=" << SimdSampler::isaName(SimdSampler::detect()) << "\n";
+    if (reader.deviation)
+        out << "# \tdeviation=1\n";
+    if (dumpEvents)
+    {
+        out << "# \tevents file=" << reader.events.path << " stride=" << reader.events.stride << " limit=" << reader.events.limit
+            << " writer=" << (reader.events.async ? "async" : "sync") << "\n";
+    }
+    if (reader.isBeam())
+    {
+        out << "# \twidth=" << reader.width << "\n";
+        out << "# \tdivergence=" << reader.divergence*180./M_PI << "\n";
+        if (reader.method == CountMethod::quadrature)
+            out << "# \tnodes=" << reader.nodes << "\n";
+    }
+    out << "# \tthreads=" << Parallel::threads(reader.nThreads) << "\n";
+    out << "# \tseed=" << seed << "\n";
+    for (const Component & component : reader.components)
+        out << "# \tcomponent fraction=" << component.fraction << " sigma=" << component.sigma << "\n";
+    for (const Injector & injector : reader.injectors)
+    {
+        out << "# \tinjector\n";
+        out << "# \t\ttheta=" << injector.point.theta << "\n";
+        out << "# \t\tsigma=" << injector.point.sigma << "\n";
+        out << "# \t\tweight=" << injector.weight << "\n";
+        out << "# \t\tposition\n";
+        out << "# \t\t\tz " << injector.point.z << "\n# \t\t\tr " << injector.point.r << "\n";
+    }
+    out << "#\n";
+    out.flush();
 }
 
-void Counter::printResult() const
+template <class Value>
+void Counter::printMap(Value value) const
 {
-    os << "# result:\n";
-    os << "# " << "nFlyby=" << getnFlyby()*100. << "%" << "\n";
-    os << "#\n";
+    const uint n = tallySize();
+    if (reader.sparseOutput)
+    {
+        // только ячейки линии в порядке гистограммы, для пучка еще ненулевые ячейки вне линии,
+        // поэтому у каждой строки, как и в полной таблице, признак ячейки линии
+        out << "# iz ir nCap line\n";
+        for (uint i = 0; i < n; i++)
+        {
+            const uint cell = cellIndex(i);
+            const double v = value(i);
+            if (!sparse && v == 0. && !reader.lineCell[cell])
+                continue;
+            out << cell / nr << " " << cell % nr << " " << v << " " << reader.lineCell[cell] << "\n";
+        }
+        return;
+    }
+
+    // полная таблица nz x nr; элементы разреженной гистограммы идут в порядке линии,
+    // поэтому обходятся отсортированными по номеру ячейки
+    std::vector<std::pair<uint, uint>> order;
+    if (sparse)
+    {
+        order.reserve(ns);
+        for (uint is = 0; is < ns; is++)
+            order.emplace_back(cellIndex(is), is);
+        std::sort(order.begin(), order.end());
+    }
+    uint k = 0;
     for (uint iz = 0; iz < nz; iz++)
     {
         for (uint ir = 0; ir < nr; ir++)
-            os << getnCap(iz*nr+ir) << " " << reader.lineCell[iz*nr+ir] << " ";
-        os << "\n";
+        {
+            const uint cell = iz*nr+ir;
+            double v = 0.;
+            if (!sparse)
+                v = value(cell);
+            else if (k < order.size() && order[k].first == cell)
+                v = value(order[k++].second);
+            out << v << " " << reader.lineCell[cell] << " ";
+        }
+        out << "\n";
+    }
+}
+
+void Counter::printResult() const
+{
+    TimeProfiler t_print("time print result");
+    out << "# result:\n";
+    out << "# " << "nFlyby=" << getnFlyby()*100. << "%" << "\n";
+    out << "#\n";
+    printMap([this](uint i) { return getnCap(i); });
+
+    if (reader.deviation && !isExact() && !reader.isBeam())
+        printDeviation();
+
+    for (uint ic = 0; ic < componentCap.size(); ic++)
+        printComponent(ic);
+    out.flush();
+}
+
+ResultHeader Counter::resultHeader() const
+{
+    ResultHeader header;
+    std::memcpy(header.magic, ResultFile::MAGIC, sizeof(header.magic));
+    header.nz = nz;
+    header.nr = nr;
+    header.method = static_cast<uint32_t>(reader.method);
+    header.flags = (isExact() ? 0 : ResultFile::COUNTS) | (reader.ni2d ? ResultFile::NI_2D : 0);
+    header.precision = reader.precision;
+    header.cells = 0;
+    header.seed = seed;
+    header.particles = nParticles;
+    header.sigma = sigma;
+    header.theta = theta*180./M_PI;
+    header.z = position.first;
+    header.r = position.second;
+    header.normaN = reader.normaDensity;
+    header.nFlyby = getnFlyby();
+    return header;
+}
+
+bool Counter::writeBinary() const
+{
+    TimeProfiler t_binary("time write binary");
+    static_assert(sizeof(uiarray::value_type) == sizeof(uint32_t), "nCap пишется как uint32");
+    ResultHeader header = resultHeader();
+    const void *cap = isExact() ? static_cast<const void *>(nCapExact.data()) : static_cast<const void *>(nCap.data());
+    if (!reader.sparseOutput && !sparse)
+        return ResultFile::write(reader.binaryPath, header, zArray.data(), rArray.data(), ni.data(), nullptr, cap, reader.lineCell);
+    if (!reader.sparseOutput)
+    {
+        // гистограмма по линии раскладывается на всю сетку nz*nr
+        std::vector<uint32_t> counts(isExact() ? 0 : nz*nr, 0);
+        darray fractions(isExact() ? nz*nr : 0, 0.);
+        for (uint is = 0; is < ns; is++)
+        {
+            if (isExact())
+                fractions[cellIndex(is)] += nCapExact[is];
+            else
+                counts[cellIndex(is)] += nCap[is];
+        }
+        cap = isExact() ? static_cast<const void *>(fractions.data()) : static_cast<const void *>(counts.data());
+        return ResultFile::write(reader.binaryPath, header, zArray.data(), rArray.data(), ni.data(), nullptr, cap, reader.lineCell);
+    }
+
+    // при output=sparse пишутся те же ячейки, что и в текстовом списке
+    std::vector<uint32_t> cells;
+    std::vector<uint32_t> counts;
+    darray fractions;
+    std::vector<bool> lineCell;
+    for (uint i = 0; i < tallySize(); i++)
+    {
+        const uint cell = cellIndex(i);
+        if (!sparse && getnCap(i) == 0. && !reader.lineCell[cell])
+            continue;
+        cells.push_back(cell);
+        if (isExact())
+            fractions.push_back(nCapExact[i]);
+        else
+            counts.push_back(nCap[i]);
+        lineCell.push_back(reader.lineCell[cell]);
+    }
+    header.flags |= ResultFile::SPARSE;
+    header.cells = cells.size();
+    cap = isExact() ? static_cast<const void *>(fractions.data()) : static_cast<const void *>(counts.data());
+    return ResultFile::write(reader.binaryPath, header, zArray.data(), rArray.data(), ni.data(), cells.data(), cap, lineCell);
+}
+
+void Counter::printComponent(uint ic) const
+{
+    // доли от числа частиц компоненты
+    const double n = componentParticles[ic] > 0 ? componentParticles[ic] : 1.;
+    out << "#\n";
+    out << "# component " << ic << ": fraction=" << components[ic].fraction << " sigma=" << components[ic].sigma
+       << " particles=" << componentParticles[ic] << "\n";
+    out << "# result:\n";
+    out << "# " << "nFlyby=" << (isExact() ? componentFlybyExact[ic] : componentFlyby[ic] / n)*100. << "%" << "\n";
+    out << "#\n";
+    printMap([&](uint i) { return isExact() ? componentExact[ic][i] : componentCap[ic][i] / n; });
+}
+
+void Counter::printDeviation() const
+{
+    out << "#\n";
+    out << "# deviation:\n";
+    out << "# nFlyby " << getnFlyby() << " " << nFlybyExact << " " << getnFlyby() - nFlybyExact << "\n";
+    out << "# iz ir mc analytic mc-analytic\n";
+    for (uint is = 0; is < ns; is++)
+    {
+        uint iz = reader.index[is].first;
+        uint ir = reader.index[is].second;
+        double mc = getnCap(lineTally(is));
+        double exact = nCapExact[lineTally(is)];
+        out << "# " << iz << " " << ir << " " << mc << " " << exact << " " << mc - exact << "\n";
     }
 }
 
 Counter::~Counter()
 {
-    TimeProfiler::print(os);
+    {
+        TimeProfiler t_sync("time write text");
+        out.sync();
+    }
+    if (printProfile)
+        TimeProfiler::print(os);
+    // main выключает трассу, если колода прочитана с ошибкой
+    if (printProfile && !reader.tracePath.empty() && TimeProfiler::isTracing() && !TimeProfiler::writeTrace(reader.tracePath))
+        std::cerr << "не удалось записать трассу " << reader.tracePath << "\n";
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "DeckReader.h"
+
+#include <cstdlib>
+#include <cerrno>
+
+static bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '=';
+}
+
+DeckReader::DeckReader(std::istream &in, uint &numberLine) : numberLine(numberLine)
+{
+    // вся колода одним блоком, дальше строки и слова - участки этого буфера
+    std::vector<char> chunk(1 << 16);
+    while (in.read(chunk.data(), chunk.size()) || in.gcount() > 0)
+        buffer.append(chunk.data(), in.gcount());
+
+    cursor = buffer.data();
+    end = buffer.data() + buffer.size();
+    lineBegin = cursor;
+    lineEnd = cursor;
+    tokens.reserve(16);
+}
+
+bool DeckReader::next()
+{
+    tokens.clear();
+    if (cursor >= end)
+        return false;
+
+    numberLine++;
+    lineBegin = cursor;
+    const char *newline = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+    lineEnd = newline ? newline : end;
+    cursor = newline ? newline + 1 : end;
+    tokenize();
+    return true;
+}
+
+bool DeckReader::skip()
+{
+    while (next())
+    {
+        if (!tokens.empty())
+            return true;
+    }
+    return false;
+}
+
+void DeckReader::tokenize()
+{
+    const char *p = lineBegin;
+    while (p < lineEnd)
+    {
+        while (p < lineEnd && isSeparator(*p))
+            p++;
+        if (p == lineEnd || *p == '#')
+            break;
+
+        const char *begin = p;
+        while (p < lineEnd && !isSeparator(*p))
+            p++;
+        tokens.push_back({begin, static_cast<size_t>(p - begin)});
+    }
+}
+
+size_t DeckReader::find(const char *key) const
+{
+    for (size_t i = 0; i + 1 < tokens.size(); i++)
+    {
+        if (tokens[i] == key)
+            return i + 1;
+    }
+    return tokens.size();
+}
+
+bool DeckReader::has(const char *word) const
+{
+    for (const Span & token : tokens)
+    {
+        if (token == word)
+            return true;
+    }
+    return false;
+}
+
+bool DeckReader::toDouble(const Span &word, double &val)
+{
+    // слово всегда кончается разделителем или концом буфера, strtod за него не выходит
+    char *e;
+    errno = 0;
+    const double res = std::strtod(word.ptr, &e);
+    if (e == word.ptr || errno == ERANGE)
+        return false;
+    val = res;
+    return true;
+}
+
+bool DeckReader::toUnsigned(const Span &word, uint &val)
+{
+    char *e;
+    errno = 0;
+    const unsigned long res = std::strtoul(word.ptr, &e, 10);
+    if (e == word.ptr || errno == ERANGE)
+        return false;
+    val = static_cast<uint>(res);
+    return true;
+}
+
+bool DeckReader::getDouble(const char *key, double &val) const
+{
+    const size_t i = find(key);
+    return i < tokens.size() && toDouble(tokens[i], val);
+}
+
+bool DeckReader::getUnsigned(const char *key, uint &val) const
+{
+    const size_t i = find(key);
+    return i < tokens.size() && toUnsigned(tokens[i], val);
+}
+
+bool DeckReader::getUnsignedLL(const char *key, unsigned long long &val) const
+{
+    const size_t i = find(key);
+    if (i == tokens.size())
+        return false;
+
+    char *e;
+    errno = 0;
+    const unsigned long long res = std::strtoull(tokens[i].ptr, &e, 10);
+    if (e == tokens[i].ptr || errno == ERANGE)
+        return false;
+    val = res;
+    return true;
+}
+
+bool DeckReader::getWord(const char *key, std::string &val) const
+{
+    const size_t i = find(key);
+    if (i == tokens.size())
+        return false;
+    val = tokens[i].str();
+    return true;
+}
+
+bool DeckReader::readValues(darray &values, size_t count)
+{
+    values.reserve(count);
+    while (values.size() < count)
+    {
+        if (!next())
+            return false;
+        if (!parseValues(lineBegin, lineEnd, values, count))
+            return false;
+    }
+    return true;
+}
+
+bool DeckReader::parseValues(const char *p, const char *end, darray &values, size_t count)
+{
+    while (values.size() < count)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            p++;
+        if (p < end && *p == '#')
+        {
+            while (p < end && *p != '\n')
+                p++;
+            continue;
+        }
+        if (p == end || *p == '\0')
+            return true;
+
+        char *e;
+        const double val = std::strtod(p, &e);
+        if (e == p || (e < end && *e != ' ' && *e != '\t' && *e != '\r' && *e != '\n' && *e != '#'))
+            return false;
+        values.push_back(val);
+        p = e;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#include "DoubleArray.h"
+
+#include <cstring>
+#include <cstdint>
+
+constexpr const char *DoubleArray::MAGIC;
+const size_t DoubleArray::HEADER;
+
+DoubleArray::DoubleArray(darray &&values)
+{
+    std::shared_ptr<darray> data = std::make_shared<darray>(std::move(values));
+    ptr = data->data();
+    length = data->size();
+    owner = data;
+}
+
+bool DoubleArray::isBinary(const MappedFile &file)
+{
+    return file.size() >= HEADER && std::memcmp(file.data(), MAGIC, 8) == 0;
+}
+
+bool DoubleArray::map(const std::shared_ptr<MappedFile> &file, DoubleArray &array, std::string &error)
+{
+    const uint16_t probe = 1;
+    if (*reinterpret_cast<const uint8_t *>(&probe) != 1)
+    {
+        error = "двоичные массивы читаются только на little-endian";
+        return false;
+    }
+    if (!isBinary(*file))
+    {
+        error = "файл не является двоичным массивом " + std::string(MAGIC);
+        return false;
+    }
+
+    uint64_t n = 0;
+    std::memcpy(&n, file->data() + 8, sizeof(n));
+    // n из файла: HEADER + n*sizeof(double) может переполниться, сравнивается с числом double после заголовка
+    if (n > (file->size() - HEADER) / sizeof(double))
+    {
+        error = "двоичный массив короче указанного в заголовке числа элементов";
+        return false;
+    }
+
+    // mmap выравнивает начало файла по странице, данные после 16 байт заголовка выровнены по double
+    array.owner = file;
+    array.ptr = reinterpret_cast<const double *>(file->data() + HEADER);
+    array.length = n;
+    return true;
+}
@@ -0,0 +1,145 @@
+#include "EventDump.h"
+
+#include <cstring>
+#include <algorithm>
+#include <ios>
+
+constexpr const char *EventDump::MAGIC;
+
+static_assert(sizeof(CaptureEvent) == 12, "CaptureEvent без выравнивающих дыр");
+static_assert(sizeof(EventHeader) == 48, "EventHeader без выравнивающих дыр");
+
+EventDump::EventDump(const EventOptions &options0, uint nz, uint nr, unsigned long long seed) :
+    options(options0), nextChunk(0), threshold(UINT64_MAX)
+{
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.nz = nz;
+    header.nr = nr;
+    header.stride = options.stride;
+    header.recordSize = sizeof(CaptureEvent);
+    header.limit = options.limit;
+    header.seed = seed;
+    header.events = 0;
+
+    file.open(options.path, std::ios::binary);
+    if (!file.is_open())
+        return;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writer.reset(new ByteWriter(file, options.async));
+}
+
+void EventDump::write(const std::vector<CaptureEvent> &events)
+{
+    writer->write(reinterpret_cast<const char *>(events.data()), events.size()*sizeof(CaptureEvent));
+    header.events += events.size();
+}
+
+void EventDump::startRun()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    nextChunk = 0;
+}
+
+void EventDump::commit(uint chunk, std::vector<CaptureEvent> &events)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!writer)
+        return;
+    if (chunk != nextChunk)
+    {
+        pending[chunk].swap(events);
+        return;
+    }
+    write(events);
+    for (nextChunk++; !pending.empty() && pending.begin()->first == nextChunk; nextChunk++)
+    {
+        write(pending.begin()->second);
+        pending.erase(pending.begin());
+    }
+}
+
+void EventDump::offer(const std::vector<Keyed> &events)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Keyed & event : events)
+    {
+        if (reservoir.size() < options.limit)
+        {
+            reservoir.push_back(event);
+            std::push_heap(reservoir.begin(), reservoir.end(), heapLess);
+        }
+        else if (event.first < reservoir.front().first)
+        {
+            std::pop_heap(reservoir.begin(), reservoir.end(), heapLess);
+            reservoir.back() = event;
+            std::push_heap(reservoir.begin(), reservoir.end(), heapLess);
+        }
+    }
+    if (reservoir.size() == options.limit)
+        threshold.store(reservoir.front().first, std::memory_order_relaxed);
+}
+
+bool EventDump::close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!writer)
+        return true;
+
+    // порции пишутся только по порядку, здесь ожидающих не остается
+    for (const auto & chunk : pending)
+        write(chunk.second);
+    pending.clear();
+
+    // выборка пишется по возрастанию ключа, чтобы файл не зависел от порядка потоков
+    std::sort(reservoir.begin(), reservoir.end(), heapLess);
+    for (const Keyed & event : reservoir)
+        writer->write(reinterpret_cast<const char *>(&event.second), sizeof(CaptureEvent));
+    header.events += reservoir.size();
+    reservoir.clear();
+
+    writer->sync();
+    writer.reset();
+    const bool written = file.good();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.close();
+    return written && !file.fail();
+}
+
+void EventBuffer::push(const CaptureEvent &event)
+{
+    if (dump->getLimit() == 0)
+    {
+        events.push_back(event);
+        return;
+    }
+
+    // ключ - хеш от номера потока Philox и номера события в нем; событие с ключом больше
+    // вершины полной общей выборки в нее уже не попадет, в порции остаются limit наименьших
+    const uint64_t key = hash(hash(stream) ^ index++);
+    if (key >= dump->getThreshold())
+        return;
+    if (reservoir.size() < dump->getLimit())
+    {
+        reservoir.emplace_back(key, event);
+        std::push_heap(reservoir.begin(), reservoir.end(), EventDump::heapLess);
+    }
+    else if (key < reservoir.front().first)
+    {
+        std::pop_heap(reservoir.begin(), reservoir.end(), EventDump::heapLess);
+        reservoir.back() = std::make_pair(key, event);
+        std::push_heap(reservoir.begin(), reservoir.end(), EventDump::heapLess);
+    }
+}
+
+void EventBuffer::end()
+{
+    if (!dump)
+        return;
+    if (dump->getLimit() == 0)
+        dump->commit(chunk, events);
+    else if (!reservoir.empty())
+        dump->offer(reservoir);
+    events.clear();
+    reservoir.clear();
+}
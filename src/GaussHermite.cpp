@@ -0,0 +1,59 @@
+#include "GaussHermite.h"
+
+#include <cmath>
+
+void GaussHermite::nodes(uint n, darray &x, darray &w)
+{
+    // корни полиномов Эрмита H_n методом Ньютона (Numerical Recipes, gauher),
+    // затем переход от веса exp(-x^2) к exp(-x^2/2)/sqrt(2 pi)
+    const double PIM4 = 0.7511255444649425; // pi^(-1/4)
+    const uint MAXIT = 100;
+
+    x.assign(n, 0.);
+    w.assign(n, 0.);
+
+    const uint m = (n + 1) / 2;
+    double z = 0.;
+    for (uint i = 0; i < m; i++)
+    {
+        if (i == 0)
+            z = sqrt(2.*n + 1.) - 1.85575*pow(2.*n + 1., -0.16667);
+        else if (i == 1)
+            z -= 1.14*pow(n, 0.426) / z;
+        else if (i == 2)
+            z = 1.86*z - 0.86*x[0];
+        else if (i == 3)
+            z = 1.91*z - 0.91*x[1];
+        else
+            z = 2.*z - x[i-2];
+
+        double pp = 0.;
+        for (uint it = 0; it < MAXIT; it++)
+        {
+            double p1 = PIM4;
+            double p2 = 0.;
+            for (uint j = 0; j < n; j++)
+            {
+                double p3 = p2;
+                p2 = p1;
+                p1 = z*sqrt(2./(j + 1.))*p2 - sqrt(j/(j + 1.))*p3;
+            }
+            pp = sqrt(2.*n)*p2;
+            double z1 = z;
+            z = z1 - p1/pp;
+            if (fabs(z - z1) <= 1e-14)
+                break;
+        }
+
+        x[i] = z;
+        x[n-1-i] = -z;
+        w[i] = 2./(pp*pp);
+        w[n-1-i] = w[i];
+    }
+
+    for (uint i = 0; i < n; i++)
+    {
+        x[i] *= sqrt(2.);
+        w[i] /= sqrt(M_PI);
+    }
+}
@@ -0,0 +1,162 @@
+#include "Injectors.h"
+
+#include <sstream>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+#include "Counter.h"
+#include "Parallel.h"
+#include "TimeProfiler.h"
+#include "TextWriter.h"
+
+void Injectors::run()
+{
+    TimeProfiler t_injectors("time injectors");
+    const std::vector<Injector> &injectors = reader.getInjectors();
+    const uint nInjectors = injectors.size();
+    const uint nThreads = Parallel::threads(reader.getThreads());
+    // оставшиеся потоки делятся между инжекторами
+    const uint nInner = std::max(1u, nThreads / nInjectors);
+
+    std::vector<std::unique_ptr<InputReader>> readers(nInjectors);
+    std::vector<std::unique_ptr<std::ostringstream>> outs(nInjectors);
+    std::vector<std::unique_ptr<Counter>> counters(nInjectors);
+
+    Parallel::run(nInjectors, nThreads, [&](uint k, uint) {
+        TimeProfiler::Tag tag("injector", k);
+        const Injector &injector = injectors[k];
+        outs[k].reset(new std::ostringstream);
+        std::ostringstream &out = *outs[k];
+        out.precision(reader.getPrecision());
+        out << std::scientific;
+        out << "# injector " << k << ": theta=" << injector.point.theta << " z=" << injector.point.z << " r=" << injector.point.r
+            << " sigma=" << injector.point.sigma << " weight=" << injector.weight << "\n";
+
+        InputReader injectorReader(reader);
+        injectorReader.setSeed(seed + k);
+        injectorReader.setThreads(nInner);
+        if (!injectorReader.setCountPoint(injector.point))
+        {
+            out << injectorReader.getError();
+            return;
+        }
+
+        counters[k].reset(new Counter(std::move(injectorReader), out));
+        counters[k]->count();
+    });
+
+    // суммарная карта по номеру ячейки iz*nr+ir: только ячейки линий и ненулевые ячейки пучков
+    const uint nz = reader.getNz();
+    const uint nr = reader.getNr();
+    std::map<uint, std::pair<double, bool>> cells;
+    double nFlyby = 0.;
+    double weight = 0.;
+    for (uint k = 0; k < nInjectors; k++)
+    {
+        if (!counters[k])
+            continue;
+        const Counter &counter = *counters[k];
+        const double w = injectors[k].weight;
+        for (uint i = 0; i < counter.tallySize(); i++)
+        {
+            const uint cell = counter.cellIndex(i);
+            const double cap = counter.getnCap(i);
+            const bool line = counter.getReader().isLineCell(cell);
+            if (cap == 0. && !line)
+                continue;
+            std::pair<double, bool> &sum = cells[cell];
+            sum.first += w*cap;
+            sum.second = sum.second || line;
+        }
+        nFlyby += w*counter.getnFlyby();
+        weight += w;
+    }
+
+    // суммарная карта - через TextWriter, как и весь остальной результат; main синхронизирует
+    // вывод своего Counter до run(), иначе его буфер попал бы в файл после этих строк
+    TextWriter out(os, reader.getPrecision(), reader.isAsyncOutput());
+    out << "# injectors=" << nInjectors << "\n";
+    if (weight > 0.)
+    {
+        out << "# result:\n";
+        out << "# " << "nFlyby=" << nFlyby / weight * 100. << "%" << "\n";
+        out << "#\n";
+        if (reader.isSparseOutput())
+        {
+            out << "# iz ir nCap line\n";
+            for (const auto & cell : cells)
+                out << cell.first / nr << " " << cell.first % nr << " " << cell.second.first / weight << " " << cell.second.second << "\n";
+        }
+        else
+        {
+            auto it = cells.begin();
+            for (uint iz = 0; iz < nz; iz++)
+            {
+                for (uint ir = 0; ir < nr; ir++)
+                {
+                    double cap = 0.;
+                    bool line = false;
+                    if (it != cells.end() && it->first == iz*nr+ir)
+                    {
+                        cap = it->second.first / weight;
+                        line = it->second.second;
+                        ++it;
+                    }
+                    out << cap << " " << line << " ";
+                }
+                out << "\n";
+            }
+        }
+    }
+
+    const std::string &binaryPath = reader.getBinaryPath();
+    const auto first = std::find_if(counters.begin(), counters.end(), [](const std::unique_ptr<Counter> &counter) { return counter != nullptr; });
+    if (!binaryPath.empty() && weight > 0. && first != counters.end())
+    {
+        // суммарная карта пишется долями, параметры линии - первого посчитанного инжектора
+        ResultHeader header = (*first)->resultHeader();
+        header.flags &= ~ResultFile::COUNTS;
+        header.nFlyby = nFlyby / weight;
+
+        std::vector<uint32_t> index;
+        darray nCap;
+        std::vector<bool> lineCell;
+        if (reader.isSparseOutput())
+        {
+            header.flags |= ResultFile::SPARSE;
+            header.cells = cells.size();
+            for (const auto & cell : cells)
+            {
+                index.push_back(cell.first);
+                nCap.push_back(cell.second.first / weight);
+                lineCell.push_back(cell.second.second);
+            }
+        }
+        else
+        {
+            nCap.assign(nz*nr, 0.);
+            lineCell.assign(nz*nr, false);
+            for (const auto & cell : cells)
+            {
+                nCap[cell.first] = cell.second.first / weight;
+                lineCell[cell.first] = cell.second.second;
+            }
+        }
+        if (!ResultFile::write(binaryPath, header, (*first)->getZArray().data(), (*first)->getRArray().data(),
+                               (*first)->getNi().data(), reader.isSparseOutput() ? index.data() : nullptr, nCap.data(), lineCell))
+            std::cerr << "не удалось записать " << binaryPath << "\n";
+    }
+
+    for (uint k = 0; k < nInjectors; k++)
+    {
+        // printResult при writer=async только ставит буфер в очередь - текст нужен целиком
+        if (counters[k])
+        {
+            counters[k]->printResult();
+            counters[k]->syncOutput();
+        }
+        out << "#\n" << outs[k]->str();
+    }
+}
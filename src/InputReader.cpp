@@ -1,133 +1,115 @@
 #include "InputReader.h"
-#include "StringReader.h"
+#include "TimeProfiler.h"
 
 #include <cmath>
-
-bool InputReader::traceLine(int step, uint &iz0, uint &ir0, double sinTheta, double cosTheta, double z0, double r0, std::vector <std::pair<std::pair<uint, uint>, double>> &temp, 
-                            bool (*condition) (uint iz0, uint ir0, uint nz, uint nr))
-{
-    double tPrevious = 0.;
-    const uint points = 4;
-    double t[points];
-    bool first = true;
-    while (condition(iz0, ir0, nz, nr))
-    {
-
-        double z1 = zArray[iz0];
-        double z2 = zArray[iz0+1];
-        double r1 = rArray[ir0];
-        double r2 = rArray[ir0+1];
-
-        t[0] = (z1 - z0) / cosTheta;
-        t[1] = (z2 - z0) / cosTheta;
-        t[2] = (r1 - r0) / sinTheta;
-        t[3] = (r2 - r0) / sinTheta;
-
-        double l = 0;
-
-        bool find = false;
-
-        for (uint it = 0; it < points; it++)
-        {
-            if ((t[it] >= tPrevious && step < 0) || ((t[it] <= tPrevious) && step > 0) )
-                continue;
-
-            double z = z0 + t[it]*cosTheta;
-            double r = r0 + t[it]*sinTheta;
-            l = std::abs(tPrevious - t[it]);
-
-            if ( ((z >= z1 && z <= z2) || (it < 2))  && ((r >= r1 && r <= r2) || it > 1))
-            {
-                switch (it)
-                {
-                case 0:
-                    iz0 += step;
-                    break;
-                case 1:
-                    iz0 += step;
-                    break;
-                case 2:
-                    ir0 -= step;
-                    break;
-                case 3:
-                    ir0 -= step;
-                    break;
-                }
-                tPrevious = t[it];
-                find = true;
-                break;
-            }
-
-        }
-
-        if (!find)
-        {
-            errorMessage("не удалось построить линию");
-            return false;
-        }
-
-        if (!first)
-            temp.back().second = l;
-        else
-        {
-            temp.front().second += l;
-            first = false;
-        }
-        if (condition(iz0, ir0, nz, nr)) {
-            temp.emplace_back(std::pair<uint, uint>(iz0, ir0), 0);
-            ns++;
-        }
-
-
-    }
-
-    return true;
-        
-}
+#include <limits>
 
 InputReader::InputReader(std::istream &in)
 {
-    std::string line = "";
     work = true;
     error_message = "";
     numberLine = 0;
     
     {
         precision = 10;
+        sparseOutput = false;
+        asyncOutput = false;
+        perfCounters = false;
         sigma = 0.;
         normaDensity = 1.;
         nParticles = 0;
+        method = CountMethod::binary;
+        deviation = false;
+        nThreads = 1;
+        hasThreads = false;
+        hasSeed = false;
+        seed = 0;
+        width = 0.;
+        divergence = 0.;
+        nodes = 8;
+        events = {"", 1, 0, false};
     }
     
+    zUniform = false;
+    rUniform = false;
+    ni2d = false;
+    nz = 0;
+    nr = 0;
+
     bool findMesh = false;
     bool findCount = false;
 
-    while (getline(in, line, true))
     {
-        if (line.empty() || isComment(line))
-            continue;
-
-        StringReader::getUnsignedParameter(line, "precision=", precision);
-        StringReader::getDoubleParameter(line, "normaN=", normaDensity);
-
-        if (normaDensity <= 0.)
-            normaDensity = 1.;
+        TimeProfiler t_parse("time read input");
+        DeckReader deck(in, numberLine);
 
-        if (!findMesh && isLine(line, "mesh")) 
+        while (deck.next())
         {
-            findMesh = true;
-            work = readMesh(in);
-            if (!work)
-                return;
-        }
-        else if (isLine(line, "count")) {
-            findCount = true;
-            work = readCount(in);
-            if (!work)
+            if (deck.isEmpty())
+                continue;
+
+            deck.getUnsigned("precision", precision);
+            deck.getDouble("normaN", normaDensity);
+            deck.getWord("binary", binaryPath);
+            deck.getWord("trace", tracePath);
+            if (!readOutput(deck) || !readPerf(deck))
+            {
+                work = false;
                 return;
+            }
+
+            if (normaDensity <= 0.)
+                normaDensity = 1.;
+
+            if (!findMesh && deck.isBlock("mesh")) 
+            {
+                findMesh = true;
+                work = readMesh(deck);
+                if (!work)
+                    return;
+            }
+            else if (deck.isBlock("count")) {
+                findCount = true;
+                work = readCount(deck);
+                if (!work)
+                    return;
+            }
+            else if (deck.isBlock("sweep")) {
+                work = readSweep(deck);
+                if (!work)
+                    return;
+            }
         }
     }
 
+    // sweep заменяет точку и сечение count целиком, инжекторы и компоненты со своими сечениями он бы молча отбросил
+    if (hasSweep() && !injectors.empty())
+    {
+        work = false;
+        errorMessage("sweep не совместим с injector");
+        return;
+    }
+    // точки sweep пишут только текстовый блок, а инжекторы - только суммарный двоичный результат:
+    // файл событий и двоичный файл точки sweep не записались бы, хотя printStartInfo их называет
+    if (hasSweep() && (!events.path.empty() || !binaryPath.empty()))
+    {
+        work = false;
+        errorMessage("sweep не совместим с events и binary, результаты точек пишутся текстом");
+        return;
+    }
+    if (!injectors.empty() && !events.path.empty())
+    {
+        work = false;
+        errorMessage("injector не совместим с events");
+        return;
+    }
+    if (!sweepSigma.empty() && !components.empty())
+    {
+        work = false;
+        errorMessage("sweep sigma не совместим с component, сечения задаются в component");
+        return;
+    }
+
     if (!findMesh) 
     {
         work = false;
@@ -139,7 +121,8 @@ InputReader::InputReader(std::istream &in)
         errorMessage("не указан count");
     }
 
-    if (!generateInjectionLine())
+    // без сетки линию строить не по чему
+    if (work && !generateInjectionLine())
     {
         work = false;
     }
@@ -168,77 +151,32 @@ void InputReader::errorConfigConstNumberPar(std::string part1, const std::vector
     errorMessage(part1+part2);
 }
 
-uint InputReader::countSpace(std::string line) const
-{
-    uint space = 0;
-    while (line[space] == ' ')
-        space++;
-    return space;
-}
-
-void InputReader::skip(std::istream &in, std::string &line, bool ignoreEqual)
-{
-    getline(in, line, true, ignoreEqual);
-    while ((line == " " || line == "" || isComment(line)) && !in.fail())
-    {
-        getline(in, line, true, ignoreEqual);
-    }
-
-    if (in.fail())
-        line = "";
-}
-
-bool InputReader::readMesh(std::istream &in)
+bool InputReader::readMesh(DeckReader &deck)
 {
-    std::string line;
-    if (!getline(in, line, true))
+    if (!deck.next())
         return false;
 
-    while(line.find("mesh end") == std::string::npos)
+    while (!deck.isEnd("mesh"))
     {
-        if (!line.empty() && !isComment(line))
+        if (!deck.isEmpty())
         {
-            if (line.find("z-axis") != std::string::npos) 
+            if (deck.token(0) == "z-axis") 
             {
-                if (!readAxis(in, zArray, nz, "z")) //добавить на условие больше нуля
+                if (!readAxis(deck, zArray, nz, zUniform, "z")) //добавить на условие больше нуля
                 return false;
             }
-            else if (line.find("r-axis") != std::string::npos)
+            else if (deck.token(0) == "r-axis")
             {
-                if (!readAxis(in, rArray, nr, "r"))
+                if (!readAxis(deck, rArray, nr, rUniform, "r"))
                     return false;
             }
-            else if (line.find("ni") != std::string::npos && nz > 0)
+            else if (deck.token(0) == "ni" && nz > 0)
             {
-                ni.clear();
-                ni.resize(nz);
-                for (uint i = 0; i < nz; i++)
-                {
-                    double val;
-                    in >> val;
-                    if (val < 0)
-                    {
-                        errorMessage("не правильное значение плотности ионов [ni >= 0]");
-                        return false;
-                    }
-                    ni[i] = val;
-                }
-                
-                if (in.fail())
-                {
-                    errorMessage("не удалось прочитать ni");
+                if (!readDensity(deck))
                     return false;
-                }
-
-            }
-                
-            if(in.fail()) {
-                errorMessage("ошибки при чтения данных");
-                return false;
             }
         }
-        skip(in, line);
-        if (in.fail()) 
+        if (!deck.skip()) 
         {
             errorMessage("не найдено закрытие mesh end");
             return false;
@@ -264,19 +202,118 @@ bool InputReader::readMesh(std::istream &in)
     return true;
 }
 
-bool InputReader::readPosition(std::istream &in, std::pair<double, double> &p)
+bool InputReader::readArrayFile(const std::string &path, DoubleArray &array, size_t count)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    if (!file)
+    {
+        errorMessage("не удалось открыть файл " + path);
+        return false;
+    }
+
+    if (DoubleArray::isBinary(*file))
+    {
+        std::string error;
+        if (!DoubleArray::map(file, array, error))
+        {
+            errorMessage(error + ": " + path);
+            return false;
+        }
+    }
+    else
+    {
+        // текстовый файл разбирается прямо из отображения; strtod останавливается
+        // на разделителе, поэтому в строку копируется только хвост после
+        // последнего разделителя - иначе strtod мог бы читать за концом файла
+        const char *begin = file->data();
+        const char *end = begin + file->size();
+        const char *tail = end;
+        while (tail > begin && tail[-1] != ' ' && tail[-1] != '\t' && tail[-1] != '\r' && tail[-1] != '\n')
+            tail--;
+        const std::string last(tail, end);
+        const size_t limit = count > 0 ? count : std::numeric_limits<size_t>::max();
+        darray values;
+        if (count > 0)
+            values.reserve(count);
+        if (!DeckReader::parseValues(begin, tail, values, limit) ||
+            !DeckReader::parseValues(last.c_str(), last.c_str() + last.size(), values, limit))
+        {
+            errorMessage("не удалось разобрать число в файле " + path);
+            return false;
+        }
+        array = DoubleArray(std::move(values));
+    }
+
+    if (count > 0 && array.size() < count)
+    {
+        errorMessage("в файле " + path + " меньше " + std::to_string(count) + " значений");
+        return false;
+    }
+    return true;
+}
+
+bool InputReader::readDensity(DeckReader &deck)
+{
+    // ni - nz значений по z, ni 2d - nz*nr значений в порядке iz*nr+ir,
+    // file=путь - значения читаются из отдельного текстового или двоичного файла
+    ni2d = deck.has("2d");
+    if (ni2d && nr == 0)
+    {
+        errorMessage("для ni 2d r-axis задается до ni");
+        return false;
+    }
+
+    std::string path;
+    if (deck.getWord("file", path))
+    {
+        if (!readArrayFile(path, ni, 0))
+            return false;
+        // двоичный файл из nz*nr значений - распределение ni(z, r) и без 2d
+        if (!ni2d && nr > 1 && ni.size() == static_cast<size_t>(nz)*nr)
+            ni2d = true;
+        const size_t size = ni2d ? static_cast<size_t>(nz)*nr : nz;
+        if (ni.size() != size)
+        {
+            errorMessage("в файле " + path + " " + std::to_string(ni.size()) + " значений ni, ожидалось " + std::to_string(size));
+            return false;
+        }
+    }
+    else
+    {
+        const size_t size = ni2d ? static_cast<size_t>(nz)*nr : nz;
+        darray values;
+        if (!deck.readValues(values, size))
+        {
+            errorMessage("не удалось прочитать ni");
+            return false;
+        }
+        ni = DoubleArray(std::move(values));
+    }
+
+    for (size_t i = 0; i < ni.size(); i++)
+    {
+        if (!(ni[i] >= 0))
+        {
+            errorMessage("не правильное значение плотности ионов [ni >= 0]");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool InputReader::readPosition(DeckReader &deck, std::pair<double, double> &p)
 {
-    std::string line;
-    
     double p1, p2;
     const uint N_PAR = 2;
     bool array[] = {false, false};
+    bool read = true;
 
     for (uint i = 0; i < N_PAR; i++)
     {
-        skip(in, line, true);
-        arrayBit(array[0], StringReader::getDoubleParameter(line, "z ", p1));
-        arrayBit(array[1], StringReader::getDoubleParameter(line, "r ", p2));
+        read = deck.skip() && read;
+        arrayBit(array[0], deck.getDouble("z", p1));
+        arrayBit(array[1], deck.getDouble("r", p2));
     }
 
     if (checkArray(array, N_PAR))
@@ -295,7 +332,7 @@ bool InputReader::readPosition(std::istream &in, std::pair<double, double> &p)
         return false;
     }
 
-    if (in.fail()) 
+    if (!read) 
     {
         errorMessage("не удалось прочитать position");
         return false;
@@ -304,40 +341,47 @@ bool InputReader::readPosition(std::istream &in, std::pair<double, double> &p)
     return true;
 }
 
-bool InputReader::readAxis(std::istream &in, darray &axis, uint &size, const std::string &name)
+bool InputReader::readAxis(DeckReader &deck, DoubleArray &axis, uint &size, bool &uniform, const std::string &name)
 {
-    std::string line;
-    skip(in, line, true);
-    if (StringReader::getUnsignedParameter(line, "n ", size)) 
+    std::string path;
+    uniform = false;
+    deck.skip();
+    if (deck.getWord("file", path))
+    {
+        // узлы сетки из файла, двоичный массив отображается без копирования
+        if (!readArrayFile(path, axis, 0))
+            return false;
+        if (axis.size() < 2)
+        {
+            errorMessage("число разбиений должно n[>=1]");
+            return false;
+        }
+        size = axis.size() - 1;
+    }
+    else if (deck.getUnsigned("n", size)) 
     {
         if (size == 0) 
         {
             errorMessage("число разбиений должно n[>=1]");
             return false;
         }
-        axis.clear();
-        axis.reserve(size+1);
-        for (uint i = 0; i < size+1; i++) 
+        darray values;
+        if (!deck.readValues(values, size+1))
         {
-            double val;
-            in >> val;
-            if (i != 0 && val <= axis.back()) 
-            {
-                errorMessage("сетка по " + name + " задается по возрастанию");
-                return false;
-            }
-            axis.push_back(val);
+            errorMessage("не удалось прочитать разбиение по " + name);
+            return false;
         }
+        axis = DoubleArray(std::move(values));
     }
-    else if (StringReader::getUnsignedParameter(line, "array ", size))
+    else if (deck.getUnsigned("array", size))
     {
         if (size == 0) 
         {
             errorMessage("число разбиений должно n[>=1]");
             return false;
         }
-        axis.clear();
-        axis.reserve(size+1);
+        darray values;
+        values.reserve(size+1);
 
         double min = 0;
         double max = 0;
@@ -347,9 +391,9 @@ bool InputReader::readAxis(std::istream &in, darray &axis, uint &size, const std
 
         for (uint i = 0; i < N_PAR; i++)
         {
-            skip(in, line, true);
-            arrayBit(array[0], StringReader::getDoubleParameter(line, "min ", min));
-            arrayBit(array[1], StringReader::getDoubleParameter(line, "max ", max));
+            deck.skip();
+            arrayBit(array[0], deck.getDouble("min", min));
+            arrayBit(array[1], deck.getDouble("max", max));
         }
 
         if (checkArray(array, N_PAR))
@@ -361,7 +405,9 @@ bool InputReader::readAxis(std::istream &in, darray &axis, uint &size, const std
             }
 
             for (uint i = 0; i < size+1; i++)
-                axis.push_back(min + (max-min)/size*i);
+                values.push_back(min + (max-min)/size*i);
+            axis = DoubleArray(std::move(values));
+            uniform = true;
 
         }
         else {
@@ -374,58 +420,124 @@ bool InputReader::readAxis(std::istream &in, darray &axis, uint &size, const std
         return false;
     }
 
-
-    if (in.fail())
+    for (size_t i = 1; i < axis.size(); i++)
     {
-        errorMessage("не удалось прочитать разбиение по " + name);
-        return false;
+        if (!(axis[i] > axis[i-1]))
+        {
+            errorMessage("сетка по " + name + " задается по возрастанию");
+            return false;
+        }
     }
 
     return true;
 }
 
-bool InputReader::readCount(std::istream &in)
+bool InputReader::readCount(DeckReader &deck)
 {
     sigma = -1.;
     theta = 0;
     position.first = 0;
     position.second = 0;
-    std::string line;
-    if (!getline(in, line, true, true))
+    injectors.clear();
+    components.clear();
+    bool findPosition = false;
+    if (!deck.next())
         return false;
 
-    while(line.find("count end") == std::string::npos)
+    while (!deck.isEnd("count"))
     {
-        if (!line.empty() && !isComment(line))
+        if (deck.isBlock("component"))
+        {
+            if (!readComponent(deck))
+                return false;
+        }
+        else if (deck.isBlock("injector"))
         {
-            StringReader::getDoubleParameter(line, "sigma ", sigma);
-            StringReader::getUnsignedParameter(line, "particles ", nParticles);
-            StringReader::getDoubleParameter(line, "theta ", theta);
+            // параметры строки injector относятся только к инжектору, не к count
+            if (!readInjector(deck))
+                return false;
+        }
+        else if (!deck.isEmpty())
+        {
+            deck.getDouble("sigma", sigma);
+            deck.getUnsigned("particles", nParticles);
+            deck.getDouble("theta", theta);
+            arrayBit(hasThreads, deck.getUnsigned("threads", nThreads));
+            deck.getDouble("width", width);
+            deck.getDouble("divergence", divergence);
+            deck.getUnsigned("nodes", nodes);
+            arrayBit(hasSeed, deck.getUnsignedLL("seed", seed));
+
+            if (!readMethod(deck))
+                return false;
 
-            if (line.find("position") != std::string::npos)
+            uint printDeviation = 0;
+            if (deck.getUnsigned("deviation", printDeviation))
+                deviation = printDeviation != 0;
+
+            if (deck.isBlock("events"))
             {
-                if (!readPosition(in, position))
+                if (!readEvents(deck))
                     return false;
             }
-
-            if(in.fail()) {
-                errorMessage("ошибки при чтения данных");
-                return false;
+            else if (deck.has("position"))
+            {
+                if (!readPosition(deck, position))
+                    return false;
+                findPosition = true;
             }
         }
-        skip(in, line, true);
-        if (in.fail()) 
+        if (!deck.skip()) 
         {
             errorMessage("не найдено закрытие count end");
             return false;
         }
     }
 
-    if (nParticles == 0)
+    if (nParticles == 0 && !isExact())
     {
         errorMessage("указано не правильное число частиц particles[>0]");
         return false;
     }
+
+    for (Injector & injector : injectors)
+    {
+        // сечения пучка с компонентами задаются только в component, свое сечение инжектора не применилось бы
+        if (!components.empty() && injector.point.sigma >= 0.)
+        {
+            errorMessage("sigma инжектора не совместим с component, сечения задаются в component");
+            return false;
+        }
+        if (injector.point.sigma < 0.)
+            injector.point.sigma = sigma;
+        if (injector.point.sigma < 0.)
+        {
+            errorMessage("указано не правильная сечение sigma инжектора [>0]");
+            return false;
+        }
+        injector.point.particles = nParticles;
+    }
+    // без своей линии в count основной линией считается первый инжектор
+    if (!injectors.empty() && !findPosition)
+    {
+        theta = injectors.front().point.theta;
+        position.first = injectors.front().point.z;
+        position.second = injectors.front().point.r;
+    }
+    if (!injectors.empty() && sigma < 0.)
+        sigma = injectors.front().point.sigma;
+
+    if (!components.empty())
+    {
+        double total = 0.;
+        for (const Component & component : components)
+            total += component.fraction;
+        for (Component & component : components)
+            component.fraction /= total;
+        if (sigma < 0.)
+            sigma = components.front().sigma;
+    }
+
     if (sigma < 0)
     {
         errorMessage("указано не правильная сечение sigma [>0]");
@@ -437,154 +549,469 @@ bool InputReader::readCount(std::istream &in)
         return false;
     }
 
+    if (width < 0. || divergence < 0.)
+    {
+        errorMessage("ширина и расходимость пучка должны быть width, divergence [>=0]");
+        return false;
+    }
+    if (isBeam() && method == CountMethod::analytic)
+    {
+        errorMessage("method analytic считает только линию без ширины и расходимости, используйте quadrature");
+        return false;
+    }
+    if (!events.path.empty() && isExact())
+    {
+        errorMessage("дамп событий events есть только у розыгрыша частиц, не у method " + methodName(method));
+        return false;
+    }
+    if (nodes == 0 || nodes > 100)
+    {
+        errorMessage("указано не правильное число узлов квадратуры nodes [>=1 <=100]");
+        return false;
+    }
+
     theta *= M_PI/180.;
+    divergence *= M_PI/180.;
 
     return true;
 }
 
-bool InputReader::generateInjectionLine()
+bool InputReader::readSweep(DeckReader &deck)
 {
-    ns = 0;
-    sArray.clear();
-    index.clear();
-    lineCell.clear();
-    lineCell.resize(nz*nr, false);
+    if (!deck.next())
+        return false;
 
-    double cosTheta = cos(theta);
-    double sinTheta = -sin(theta);
-    double z0 = position.first;
-    double r0 = position.second;
+    while (!deck.isEnd("sweep"))
+    {
+        if (!deck.isEmpty())
+        {
+            const Span &name = deck.token(0);
+
+            darray *values = nullptr;
+            if (name == "theta")
+                values = &sweepTheta;
+            else if (name == "z")
+                values = &sweepZ;
+            else if (name == "r")
+                values = &sweepR;
+            else if (name == "sigma")
+                values = &sweepSigma;
+            else if (name == "particles")
+                values = &sweepParticles;
+            else
+            {
+                errorMessage("не известный параметр sweep " + name.str() + " [theta, z, r, sigma, particles]");
+                return false;
+            }
 
-    // z = z0 + t*cos(theta)
-    // r = r0 + t*sin(theta)
-    uint iz0 = 0;
-    uint ir0 = 0;
+            values->clear();
+            if (deck.size() > 1 && deck.token(1) == "range")
+            {
+                // range min max n - n точек от min до max включительно
+                double min = 0.;
+                double max = 0.;
+                uint n = 0;
+                if (deck.size() < 5 || !DeckReader::toDouble(deck.token(2), min) || !DeckReader::toDouble(deck.token(3), max)
+                    || !DeckReader::toUnsigned(deck.token(4), n) || n == 0)
+                {
+                    errorMessage("не удалось прочитать range для " + name.str() + " [range min max n]");
+                    return false;
+                }
+                for (uint i = 0; i < n; i++)
+                    values->push_back(n == 1 ? min : min + (max-min)/(n-1)*i);
+            }
+            else
+            {
+                // каждое слово после имени - число целиком
+                for (size_t i = 1; i < deck.size(); i++)
+                {
+                    const Span &word = deck.token(i);
+                    if (!DeckReader::parseValues(word.ptr, word.ptr + word.length, *values, values->size() + 1))
+                    {
+                        values->clear();
+                        break;
+                    }
+                }
+                if (values->size() + 1 != deck.size())
+                {
+                    errorMessage("не удалось прочитать значения sweep " + name.str());
+                    return false;
+                }
+            }
+            if (values == &sweepParticles)
+            {
+                for (const double n0 : sweepParticles)
+                {
+                    if (n0 < 0. || n0 > std::numeric_limits<uint>::max() || n0 != std::floor(n0))
+                    {
+                        errorMessage("указано не правильное число частиц sweep particles [целое >=0]");
+                        return false;
+                    }
+                }
+            }
+        }
+        if (!deck.skip())
+        {
+            errorMessage("не найдено закрытие sweep end");
+            return false;
+        }
+    }
 
-    bool found = false;
+    return true;
+}
+
+std::vector<CountPoint> InputReader::getSweepPoints() const
+{
+    const darray thetas = sweepTheta.empty() ? darray{theta*180./M_PI} : sweepTheta;
+    const darray zs = sweepZ.empty() ? darray{position.first} : sweepZ;
+    const darray rs = sweepR.empty() ? darray{position.second} : sweepR;
+    const darray sigmas = sweepSigma.empty() ? darray{sigma} : sweepSigma;
+    const darray particles = sweepParticles.empty() ? darray{(double) nParticles} : sweepParticles;
+
+    std::vector<CountPoint> points;
+    points.reserve(thetas.size()*zs.size()*rs.size()*sigmas.size()*particles.size());
+    for (const double & t0 : thetas)
+        for (const double & z0 : zs)
+            for (const double & r0 : rs)
+                for (const double & s0 : sigmas)
+                    for (const double & n0 : particles)
+                        points.push_back({t0, z0, r0, s0, static_cast<uint>(n0)});
+    return points;
+}
+
+void InputReader::clearLine()
+{
+    ns = 0;
+    sArray = darray();
+    index = std::vector<std::pair<uint, uint>>();
+    lineStart = darray();
+    lineCell = std::vector<bool>();
+    sweepTheta.clear();
+    sweepZ.clear();
+    sweepR.clear();
+    sweepSigma.clear();
+    sweepParticles.clear();
+}
 
-    for (uint iz = 0; iz < nz; iz++)
+bool InputReader::setCountPoint(const CountPoint &point)
+{
+    if (point.particles == 0 && !isExact())
     {
-        double z1 = zArray[iz];
-        double z2 = zArray[iz+1];
+        errorMessage("указано не правильное число частиц particles[>0]");
+        return work = false;
+    }
+    if (point.sigma < 0)
+    {
+        errorMessage("указано не правильная сечение sigma [>0]");
+        return work = false;
+    }
+    if (!components.empty() && point.sigma != sigma)
+    {
+        errorMessage("сечение точки не совместимо с component, сечения задаются в component");
+        return work = false;
+    }
+    if (point.theta < 0. || point.theta > 90.)
+    {
+        errorMessage("не указан правильный угол инжекции theta [>=0 <=90]");
+        return work = false;
+    }
+
+    theta = point.theta*M_PI/180.;
+    position.first = point.z;
+    position.second = point.r;
+    sigma = point.sigma;
+    nParticles = point.particles;
+
+    return work = generateInjectionLine();
+}
 
-        if (z0 >= z1 && z0 < z2)
+
+bool InputReader::readInjector(DeckReader &deck)
+{
+    Injector injector;
+    injector.point.theta = 0.;
+    injector.point.sigma = -1.;
+    injector.weight = 1.;
+    std::pair<double, double> p(0., 0.);
+    bool findPosition = false;
+
+    // injector theta=20 weight=2 - параметры можно задать и в строке заголовка
+    for (size_t i = 1; i < deck.size(); i += 2)
+    {
+        const Span &name = deck.token(i);
+        double *value = nullptr;
+        if (name == "theta")
+            value = &injector.point.theta;
+        else if (name == "sigma")
+            value = &injector.point.sigma;
+        else if (name == "weight")
+            value = &injector.weight;
+        else
         {
-            iz0 = iz;
-            found = true;
-            break;
+            errorMessage("не известный параметр injector " + name.str() + " [theta, sigma, weight]");
+            return false;
+        }
+        if (i + 1 == deck.size() || !DeckReader::toDouble(deck.token(i + 1), *value))
+        {
+            errorMessage("не удалось прочитать параметр injector " + name.str());
+            return false;
         }
     }
 
-    if (!found) {
-        errorMessage("начальная точка не найдена по z");
-        return false;
-    }
-
-    found = false;
-    for (uint ir = 0; ir < nr; ir++)
+    deck.skip();
+    while (!deck.isEnd("injector"))
     {
-        double r1 = rArray[ir];
-        double r2 = rArray[ir+1];
+        deck.getDouble("theta", injector.point.theta);
+        deck.getDouble("sigma", injector.point.sigma);
+        deck.getDouble("weight", injector.weight);
 
-        if (r0 > r1 && r0 < r2)
+        if (deck.has("position"))
         {
-            ir0 = ir;
-            found = true;
-            break;
+            if (!readPosition(deck, p))
+                return false;
+            findPosition = true;
         }
-        else if (r0 == r1)
-        {
-            double t = (zArray[iz0] - z0) / cosTheta;
 
-            z0 = z0 + t/2.*cosTheta;
-            r0  = r0 + t/2.*sinTheta;
-            ir0 = ir;
-            found = true;
-            break;
+        if (!deck.skip())
+        {
+            errorMessage("не найдено закрытие injector end");
+            return false;
         }
+    }
 
+    if (!findPosition)
+    {
+        errorMessage("не указан position инжектора");
+        return false;
+    }
+    if (injector.point.theta < 0. || injector.point.theta > 90.)
+    {
+        errorMessage("не указан правильный угол инжектора theta [>=0 <=90]");
+        return false;
+    }
+    if (injector.weight <= 0.)
+    {
+        errorMessage("указан не правильный вес инжектора weight [>0]");
+        return false;
     }
 
+    injector.point.z = p.first;
+    injector.point.r = p.second;
+    injectors.push_back(injector);
+    return true;
+}
+
+bool InputReader::readComponent(const DeckReader &deck)
+{
+    // component fraction=0.6 sigma=1e-15
+    Component component;
+    const uint N_PAR = 2;
+    bool array[] = {false, false};
+    arrayBit(array[0], deck.getDouble("fraction", component.fraction));
+    arrayBit(array[1], deck.getDouble("sigma", component.sigma));
 
-    if (z0 == zArray[iz0])
+    if (!checkArray(array, N_PAR))
+    {
+        errorConfigConstNumberPar("не указаны все параметры component [", {"fraction", "sigma"}, array, N_PAR);
+        return false;
+    }
+    if (component.fraction <= 0. || component.sigma < 0.)
     {
-        double t = (rArray[ir0] - r0) / sinTheta;
-        z0 = z0 + t/2.*cosTheta;
-        r0  = r0 + t/2.*sinTheta;
+        errorMessage("не правильные параметры component fraction [>0] sigma [>=0]");
+        return false;
     }
 
+    components.push_back(component);
+    return true;
+}
 
-    if (!found) {
-        errorMessage("начальная точка не найдена по r");
+bool InputReader::readEvents(const DeckReader &deck)
+{
+    // events file=capture.evt stride=10 limit=1000000 writer=async
+    if (!deck.getWord("file", events.path))
+    {
+        errorMessage("не указан файл событий events file");
+        return false;
+    }
+    events.stride = 1;
+    events.limit = 0;
+    events.async = false;
+    deck.getUnsigned("stride", events.stride);
+    deck.getUnsignedLL("limit", events.limit);
+    if (events.stride == 0)
+    {
+        errorMessage("указан не правильный шаг прореживания событий stride [>0]");
         return false;
     }
 
-    if (fabs(sinTheta) < 1e-10)
+    std::string name;
+    if (deck.getWord("writer", name))
     {
-        for (uint iz = 0; iz < nz; iz++) {
-            index.emplace_back(iz, ir0);
-            sArray.push_back(zArray[iz+1] - zArray[iz]);
-            ns++;
+        if (name == "sync")
+            events.async = false;
+        else if (name == "async")
+            events.async = true;
+        else
+        {
+            errorMessage("не известный способ записи событий writer [sync, async]");
+            return false;
         }
     }
-    else if (fabs(cosTheta) < 1e-10)
+
+    return true;
+}
+
+bool InputReader::readOutput(const DeckReader &deck)
+{
+    std::string name;
+    if (deck.getWord("output", name))
     {
-        for (uint ir = nr-1; ir+1 > 0; ir--) {
-            index.emplace_back(iz0, ir);
-            sArray.push_back(rArray[ir+1] - rArray[ir]);
-            ns++;
+        if (name == "dense")
+            sparseOutput = false;
+        else if (name == "sparse")
+            sparseOutput = true;
+        else
+        {
+            errorMessage("не известный вид результата output [dense, sparse]");
+            return false;
         }
     }
-    else
+
+    if (deck.getWord("writer", name))
     {
-        std::vector <std::pair<std::pair<uint, uint>, double>> temp;
-        temp.emplace_back(std::pair<uint, uint>(iz0, ir0), 0);
-        ns++;
-        const uint iz0_start = iz0;
-        const uint ir0_start = ir0;
-
-        //трасировка назад
-        if (!traceLine(-1, iz0, ir0, sinTheta, cosTheta, z0, r0, temp, [](uint iz0, uint ir0, uint nz, uint nr) 
-            { 
-                return iz0 > 0 && ir0 < nr; 
-            } 
-        ))
-            return false;
-        
-        iz0 = iz0_start;
-        ir0 = ir0_start;
-        // трасировка вперед
-        if (!traceLine(1, iz0, ir0, sinTheta, cosTheta, z0, r0, temp, [](uint iz0, uint ir0, uint nz, uint nr) 
-            {
-                return iz0 < nz && ir0 > 0;
-            } 
-        ))
+        if (name == "sync")
+            asyncOutput = false;
+        else if (name == "async")
+            asyncOutput = true;
+        else
+        {
+            errorMessage("не известный способ записи writer [sync, async]");
             return false;
-        
-        std::sort(temp.begin(), temp.end(), 
-            [] (const auto &a, const auto &b) {
-                const auto &ai = a.first;
-                const auto &bi = b.first;
-                if (ai.second < bi.second)
-                    return false;
-                else if (ai.second > bi.second)
-                    return true;
-                else
-                {
-                    return ai.first < bi.first;
-                }
-            }
-        );
-
-        sArray.reserve(ns);
-        index.reserve(ns);
-        for (uint is = 0; is < ns; is++) {
-            sArray.push_back(temp[is].second);
-            index.emplace_back(temp[is].first.first, temp[is].first.second);
         }
+    }
+
+    return true;
+}
+
+bool InputReader::readPerf(const DeckReader &deck)
+{
+    std::string name;
+    if (!deck.getWord("perf", name))
+        return true;
+
+    if (name == "off")
+        perfCounters = false;
+    else if (name == "on")
+        perfCounters = true;
+    else
+    {
+        errorMessage("не известное значение perf [on, off]");
+        return false;
+    }
+
+    return true;
+}
+
+bool InputReader::readMethod(const DeckReader &deck)
+{
+    std::string name;
+    if (!deck.getWord("method", name))
+        return true;
+
+    if (name == "linear")
+        method = CountMethod::linear;
+    else if (name == "binary")
+        method = CountMethod::binary;
+    else if (name == "alias")
+        method = CountMethod::alias;
+    else if (name == "multinomial")
+        method = CountMethod::multinomial;
+    else if (name == "analytic")
+        method = CountMethod::analytic;
+    else if (name == "simd")
+        method = CountMethod::simd;
+    else if (name == "quadrature")
+        method = CountMethod::quadrature;
+    else
+    {
+        errorMessage("не известный метод розыгрыша method [linear, binary, alias, multinomial, analytic, simd, quadrature]");
+        return false;
+    }
+
+    return true;
+}
+
+std::string InputReader::methodName(CountMethod method)
+{
+    switch (method)
+    {
+    case CountMethod::linear:
+        return "linear";
+    case CountMethod::binary:
+        return "binary";
+    case CountMethod::alias:
+        return "alias";
+    case CountMethod::multinomial:
+        return "multinomial";
+    case CountMethod::analytic:
+        return "analytic";
+    case CountMethod::simd:
+        return "simd";
+    case CountMethod::quadrature:
+        return "quadrature";
+    }
+    return "";
+}
+
+bool InputReader::generateInjectionLine()
+{
+    TimeProfiler t_line("time injection line");
+    ns = 0;
+    sArray.clear();
+    index.clear();
+    lineCell.clear();
+    lineCell.resize(nz*nr, false);
 
+    double cosTheta = cos(theta);
+    double sinTheta = -sin(theta);
+    if (fabs(cosTheta) < 1e-10)
+        cosTheta = 0.;
+    if (fabs(sinTheta) < 1e-10)
+        sinTheta = 0.;
+
+    // z = z0 + t*cos(theta)
+    // r = r0 + t*sin(theta)
+    const double z0 = position.first;
+    const double r0 = position.second;
+    const LineTracer tracer = getTracer();
+
+    uint iz0 = 0;
+    uint ir0 = 0;
+    if (!tracer.findCell(z0, r0, iz0, ir0))
+    {
+        if (z0 < zArray.front() || z0 >= zArray.back())
+            errorMessage("начальная точка не найдена по z");
+        else
+            errorMessage("начальная точка не найдена по r");
+        return false;
     }
 
+    double tEntry = 0.;
+    double tExit = 0.;
+    tracer.clip(z0, r0, cosTheta, sinTheta, tEntry, tExit);
+    lineEntry = std::make_pair(z0 + tEntry*cosTheta, r0 + tEntry*sinTheta);
+    lineDirection = std::make_pair(cosTheta, sinTheta);
+    lineStart.clear();
+
+    double s = 0.;
+    tracer.trace(z0, r0, cosTheta, sinTheta, [this, &s](uint iz, uint ir, double l) {
+        index.emplace_back(iz, ir);
+        sArray.push_back(l);
+        lineStart.push_back(s);
+        s += l;
+        ns++;
+        return true;
+    });
 
     if (sArray.empty() || index.empty())
     {
@@ -594,6 +1021,7 @@ bool InputReader::generateInjectionLine()
 
     for (uint is = 0; is < ns; is++)
         lineCell[index[is].first*nr+index[is].second] = true;
+    TimeProfiler::addUnits(ns, "cell");
 
     return true;
-}
\ No newline at end of file
+}
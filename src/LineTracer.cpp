@@ -0,0 +1,66 @@
+#include "LineTracer.h"
+
+#include <cmath>
+
+uint LineTracer::locate(const DoubleArray &axis, bool uniform, double x, double d)
+{
+    const uint n = axis.size() - 1;
+    long long i;
+    if (uniform)
+    {
+        const double h = (axis[n] - axis[0]) / n;
+        const double f = (x - axis[0]) / h;
+        i = static_cast<long long>(std::floor(f));
+        if (d < 0. && f == std::floor(f))
+            i--;
+    }
+    else if (d < 0.)
+        i = std::lower_bound(axis.begin(), axis.end(), x) - axis.begin() - 1;
+    else
+        i = std::upper_bound(axis.begin(), axis.end(), x) - axis.begin() - 1;
+
+    if (i < 0)
+        return 0;
+    if (i >= n)
+        return n - 1;
+    return i;
+}
+
+bool LineTracer::clip(double z0, double r0, double dz, double dr, double &tmin, double &tmax) const
+{
+    tmin = -std::numeric_limits<double>::infinity();
+    tmax = std::numeric_limits<double>::infinity();
+
+    const double p[2] = {z0, r0};
+    const double d[2] = {dz, dr};
+    const double lo[2] = {zArray.front(), rArray.front()};
+    const double hi[2] = {zArray.back(), rArray.back()};
+
+    for (uint k = 0; k < 2; k++)
+    {
+        if (d[k] == 0.)
+        {
+            if (p[k] < lo[k] || p[k] > hi[k])
+                return false;
+            continue;
+        }
+        double t1 = (lo[k] - p[k]) / d[k];
+        double t2 = (hi[k] - p[k]) / d[k];
+        if (t1 > t2)
+            std::swap(t1, t2);
+        tmin = std::max(tmin, t1);
+        tmax = std::min(tmax, t2);
+    }
+
+    return tmin < tmax;
+}
+
+bool LineTracer::findCell(double z, double r, uint &iz, uint &ir) const
+{
+    if (z < zArray.front() || z >= zArray.back() || r < rArray.front() || r >= rArray.back())
+        return false;
+
+    iz = locate(zArray, zUniform, z, 0.);
+    ir = locate(rArray, rUniform, r, 0.);
+    return true;
+}
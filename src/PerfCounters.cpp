@@ -0,0 +1,169 @@
+#include "PerfCounters.h"
+
+#include <mutex>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// доступность по первому потоку, открывшему счетчики
+std::mutex mutex;
+bool probed = false;
+bool availableEvents[PerfCounters::N_EVENTS] = {false, false, false, false};
+std::string lastError = "perf_event не поддерживается";
+
+// дескрипторы счетчиков потока, -1 - не открыт; группа читается через ведущий
+struct ThreadCounters
+{
+    int fd[PerfCounters::N_EVENTS];
+    int leader;
+    int members[PerfCounters::N_EVENTS]; // события группы в порядке открытия
+    int nMembers;
+    bool opened;
+
+    ThreadCounters() : leader(-1), nMembers(0), opened(false)
+    {
+        for (int & f : fd)
+            f = -1;
+    }
+
+    void open();
+
+    ~ThreadCounters()
+    {
+#ifdef __linux__
+        for (int f : fd)
+        {
+            if (f >= 0)
+                close(f);
+        }
+#endif
+    }
+};
+
+thread_local ThreadCounters counters;
+
+void ThreadCounters::open()
+{
+    opened = true;
+#ifdef __linux__
+    const uint64_t config[PerfCounters::N_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                     PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    std::string error;
+    for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config[i];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC);
+        if (fd[i] < 0)
+        {
+            if (error.empty())
+                error = std::string(PerfCounters::name(static_cast<PerfCounters::Event>(i))) + ": " + std::strerror(errno);
+            continue;
+        }
+        if (leader < 0)
+            leader = fd[i];
+        members[nMembers++] = i;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (probed)
+        return;
+    probed = true;
+    for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+        availableEvents[i] = fd[i] >= 0;
+    lastError = error;
+#endif
+}
+
+}
+
+const char * PerfCounters::name(Event event)
+{
+    switch (event)
+    {
+    case CYCLES:
+        return "cycles";
+    case INSTRUCTIONS:
+        return "instructions";
+    case CACHE_MISSES:
+        return "cache-misses";
+    case BRANCH_MISSES:
+        return "branch-misses";
+    case N_EVENTS:
+        break;
+    }
+    return "";
+}
+
+bool PerfCounters::probe()
+{
+    if (!counters.opened)
+        counters.open();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const bool & a : availableEvents)
+    {
+        if (a)
+            return true;
+    }
+    return false;
+}
+
+bool PerfCounters::available(Event event)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return availableEvents[event];
+}
+
+std::string PerfCounters::error()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastError;
+}
+
+void PerfCounters::read(Values &values)
+{
+    if (!counters.opened)
+        counters.open();
+    for (uint64_t & c : values.count)
+        c = 0;
+    values.enabled = 0;
+    values.running = 0;
+#ifdef __linux__
+    if (counters.leader < 0)
+        return;
+    // PERF_FORMAT_GROUP: число событий, время enabled и running, значения в порядке открытия
+    uint64_t data[3 + N_EVENTS];
+    const ssize_t size = (3 + counters.nMembers)*sizeof(uint64_t);
+    if (::read(counters.leader, data, size) != size || data[0] != static_cast<uint64_t>(counters.nMembers))
+        return;
+    values.enabled = data[1];
+    values.running = data[2];
+    for (int k = 0; k < counters.nMembers; k++)
+        values.count[counters.members[k]] = data[3 + k];
+#endif
+}
+
+void PerfCounters::delta(const Values &start, const Values &end, uint64_t count[N_EVENTS])
+{
+    const uint64_t enabled = end.enabled - start.enabled;
+    const uint64_t running = end.running - start.running;
+    for (int i = 0; i < N_EVENTS; i++)
+    {
+        const uint64_t raw = end.count[i] - start.count[i];
+        // группа не была на PMU весь интервал: оценка по доле времени, совсем не была - ноль
+        count[i] = running == enabled ? raw : (running == 0 ? 0 : static_cast<uint64_t>(static_cast<double>(raw)*enabled / running));
+    }
+}
@@ -0,0 +1,140 @@
+#include "ResultFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <algorithm>
+
+constexpr const char *ResultFile::MAGIC;
+
+static_assert(sizeof(ResultHeader) == 96, "ResultHeader без выравнивающих дыр");
+
+size_t ResultFile::layout(const ResultHeader &header, size_t offset[6])
+{
+    const size_t cells = (header.flags & SPARSE) ? header.cells : static_cast<size_t>(header.nz)*header.nr;
+    const size_t nNi = (header.flags & NI_2D) ? static_cast<size_t>(header.nz)*header.nr : header.nz;
+
+    offset[0] = sizeof(ResultHeader);
+    offset[1] = offset[0] + (static_cast<size_t>(header.nz) + 1)*sizeof(double);
+    offset[2] = offset[1] + (static_cast<size_t>(header.nr) + 1)*sizeof(double);
+    offset[3] = offset[2] + nNi*sizeof(double);
+    offset[4] = offset[3] + ((header.flags & SPARSE) ? (cells*sizeof(uint32_t) + 7)/8*8 : 0);
+    offset[5] = offset[4] + cells*((header.flags & COUNTS) ? sizeof(uint32_t) : sizeof(double));
+    return offset[5] + (cells + 7)/8;
+}
+
+bool ResultFile::write(const std::string &path, const ResultHeader &header, const double *zArray, const double *rArray,
+                       const double *ni, const uint32_t *cells, const void *cap, const std::vector<bool> &lineCell)
+{
+    size_t offset[6];
+    const size_t size = layout(header, offset);
+
+    std::ofstream fout(path, std::ios::binary);
+    if (!fout.is_open())
+        return false;
+
+    // секции пишутся в поток по очереди, без копии всего файла в памяти
+    const char zeros[8] = {0};
+    fout.write(reinterpret_cast<const char *>(&header), sizeof(ResultHeader));
+    fout.write(reinterpret_cast<const char *>(zArray), offset[1] - offset[0]);
+    fout.write(reinterpret_cast<const char *>(rArray), offset[2] - offset[1]);
+    fout.write(reinterpret_cast<const char *>(ni), offset[3] - offset[2]);
+    if (header.flags & SPARSE)
+    {
+        fout.write(reinterpret_cast<const char *>(cells), header.cells*sizeof(uint32_t));
+        fout.write(zeros, offset[4] - offset[3] - header.cells*sizeof(uint32_t));
+    }
+    fout.write(reinterpret_cast<const char *>(cap), offset[5] - offset[4]);
+
+    // битовая карта собирается порциями
+    const size_t BLOCK = 1 << 16;
+    std::vector<char> bits;
+    bits.reserve(BLOCK);
+    for (size_t i = 0; i < size - offset[5]; i++)
+    {
+        uint8_t byte = 0;
+        for (size_t k = 8*i; k < std::min(8*i + 8, lineCell.size()); k++)
+        {
+            if (lineCell[k])
+                byte |= 1u << (k & 7);
+        }
+        bits.push_back(static_cast<char>(byte));
+        if (bits.size() == BLOCK)
+        {
+            fout.write(bits.data(), bits.size());
+            bits.clear();
+        }
+    }
+    fout.write(bits.data(), bits.size());
+    return static_cast<bool>(fout);
+}
+
+bool ResultFile::open(const std::string &path, std::string &error)
+{
+    const uint16_t probe = 1;
+    if (*reinterpret_cast<const uint8_t *>(&probe) != 1)
+    {
+        error = "двоичный результат читается только на little-endian";
+        return false;
+    }
+
+    file = MappedFile::open(path);
+    if (!file)
+    {
+        error = "не удалось открыть файл " + path;
+        return false;
+    }
+    if (file->size() < sizeof(ResultHeader) || std::memcmp(file->data(), MAGIC, 8) != 0)
+    {
+        error = "файл " + path + " не является двоичным результатом " + std::string(MAGIC);
+        return false;
+    }
+
+    // mmap выравнивает начало по странице, все массивы double лежат по смещениям кратным 8
+    head = reinterpret_cast<const ResultHeader *>(file->data());
+    // размеры из заголовка не доверенные: nz*nr и cells ограничены uint32, тогда смещения не переполняются,
+    // а длина файла проверяется по ним
+    const uint64_t nCells = static_cast<uint64_t>(head->nz)*head->nr;
+    if (nCells > UINT32_MAX || ((head->flags & SPARSE) && head->cells > nCells))
+    {
+        error = "файл " + path + ": не правильный размер сетки в заголовке";
+        return false;
+    }
+    size_t offset[6];
+    if (file->size() < layout(*head, offset))
+    {
+        error = "файл " + path + " короче указанной в заголовке сетки";
+        return false;
+    }
+
+    z = reinterpret_cast<const double *>(file->data() + offset[0]);
+    r = reinterpret_cast<const double *>(file->data() + offset[1]);
+    niArray = reinterpret_cast<const double *>(file->data() + offset[2]);
+    cells = (head->flags & SPARSE) ? reinterpret_cast<const uint32_t *>(file->data() + offset[3]) : nullptr;
+    counts = (head->flags & COUNTS) ? reinterpret_cast<const uint32_t *>(file->data() + offset[4]) : nullptr;
+    fractions = (head->flags & COUNTS) ? nullptr : reinterpret_cast<const double *>(file->data() + offset[4]);
+    lineBits = reinterpret_cast<const uint8_t *>(file->data() + offset[5]);
+    return true;
+}
+
+void ResultFile::print(std::ostream &os) const
+{
+    os.precision(head->precision);
+    os << std::scientific;
+    os << "# result:\n";
+    os << "# " << "nFlyby=" << head->nFlyby*100. << "%" << "\n";
+    os << "#\n";
+    if (isSparse())
+    {
+        os << "# iz ir nCap line\n";
+        for (uint k = 0; k < head->cells; k++)
+            os << cells[k] / head->nr << " " << cells[k] % head->nr << " " << getnCap(k) << " " << isLineCell(k) << "\n";
+        return;
+    }
+    for (uint iz = 0; iz < head->nz; iz++)
+    {
+        for (uint ir = 0; ir < head->nr; ir++)
+            os << getnCap(iz*head->nr+ir) << " " << isLineCell(iz*head->nr+ir) << " ";
+        os << "\n";
+    }
+}
@@ -0,0 +1,152 @@
+#include "SimdSampler.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SAMPLER_X86
+#endif
+
+static void findScalar(const double *table, uint half, const double *gamma, uint *cell, uint n)
+{
+    for (uint i = 0; i < n; i++)
+    {
+        uint pos = 0;
+        for (uint step = half; step > 0; step >>= 1)
+            pos += table[pos + step - 1] <= gamma[i] ? step : 0;
+        cell[i] = pos;
+    }
+}
+
+#ifdef SIMD_SAMPLER_X86
+
+__attribute__((target("sse2")))
+static void findSse2(const double *table, uint half, const double *gamma, uint *cell, uint n)
+{
+    uint i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        const __m128d g = _mm_loadu_pd(gamma + i);
+        long long pos[2] = {0, 0};
+        for (uint step = half; step > 0; step >>= 1)
+        {
+            const __m128d val = _mm_set_pd(table[pos[1] + step - 1], table[pos[0] + step - 1]);
+            const __m128i le = _mm_castpd_si128(_mm_cmple_pd(val, g));
+            __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+            p = _mm_add_epi64(p, _mm_and_si128(le, _mm_set1_epi64x(step)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(pos), p);
+        }
+        cell[i] = pos[0];
+        cell[i+1] = pos[1];
+    }
+    findScalar(table, half, gamma + i, cell + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void findAvx2(const double *table, uint half, const double *gamma, uint *cell, uint n)
+{
+    uint i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256d g = _mm256_loadu_pd(gamma + i);
+        __m256i pos = _mm256_setzero_si256();
+        for (uint step = half; step > 0; step >>= 1)
+        {
+            const __m256i s = _mm256_set1_epi64x(step);
+            const __m256d val = _mm256_i64gather_pd(table + step - 1, pos, 8);
+            const __m256i le = _mm256_castpd_si256(_mm256_cmp_pd(val, g, _CMP_LE_OQ));
+            pos = _mm256_add_epi64(pos, _mm256_and_si256(le, s));
+        }
+        long long out[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), pos);
+        for (uint k = 0; k < 4; k++)
+            cell[i+k] = out[k];
+    }
+    findScalar(table, half, gamma + i, cell + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void findAvx512(const double *table, uint half, const double *gamma, uint *cell, uint n)
+{
+    uint i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m512d g = _mm512_loadu_pd(gamma + i);
+        __m512i pos = _mm512_setzero_si512();
+        for (uint step = half; step > 0; step >>= 1)
+        {
+            const __m512d val = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, pos, table + step - 1, 8);
+            const __mmask8 le = _mm512_cmp_pd_mask(val, g, _CMP_LE_OQ);
+            pos = _mm512_mask_add_epi64(pos, le, pos, _mm512_set1_epi64(step));
+        }
+        long long out[8];
+        _mm512_storeu_si512(out, pos);
+        for (uint k = 0; k < 8; k++)
+            cell[i+k] = out[k];
+    }
+    findScalar(table, half, gamma + i, cell + i, n - i);
+}
+
+#endif
+
+SimdSampler::Isa SimdSampler::detect()
+{
+#ifdef SIMD_SAMPLER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return Isa::avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return Isa::avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return Isa::sse2;
+#endif
+    return Isa::scalar;
+}
+
+std::string SimdSampler::isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::scalar:
+        return "scalar";
+    case Isa::sse2:
+        return "sse2";
+    case Isa::avx2:
+        return "avx2";
+    case Isa::avx512:
+        return "avx512";
+    }
+    return "";
+}
+
+void SimdSampler::build(const darray &cdf)
+{
+    uint size = 1;
+    while (size <= cdf.size())
+        size <<= 1;
+
+    table.assign(size, 2.);
+    for (uint is = 0; is < cdf.size(); is++)
+        table[is] = cdf[is];
+    half = size >> 1;
+    isa = detect();
+}
+
+void SimdSampler::find(const double *gamma, uint *cell, uint n) const
+{
+    switch (isa)
+    {
+#ifdef SIMD_SAMPLER_X86
+    case Isa::avx512:
+        findAvx512(table.data(), half, gamma, cell, n);
+        return;
+    case Isa::avx2:
+        findAvx2(table.data(), half, gamma, cell, n);
+        return;
+    case Isa::sse2:
+        findSse2(table.data(), half, gamma, cell, n);
+        return;
+#endif
+    default:
+        findScalar(table.data(), half, gamma, cell, n);
+        return;
+    }
+}
@@ -0,0 +1,66 @@
+#include "Sweep.h"
+
+#include <sstream>
+#include <mutex>
+
+#include "Counter.h"
+#include "Parallel.h"
+#include "TimeProfiler.h"
+
+std::string Sweep::runPoint(const InputReader &base, uint ipoint, const CountPoint &point, uint threads) const
+{
+    TimeProfiler::Tag tag("point", ipoint);
+    std::ostringstream out;
+    out.precision(reader.getPrecision());
+    out << std::scientific;
+    out << "# sweep point " << ipoint << ": theta=" << point.theta << " z=" << point.z << " r=" << point.r
+        << " sigma=" << point.sigma << " particles=" << point.particles << "\n";
+
+    InputReader pointReader(base);
+    // у каждой точки свой ключ Philox, результат точки от числа потоков не зависит
+    pointReader.setSeed(seed + ipoint);
+    pointReader.setThreads(threads);
+    if (!pointReader.setCountPoint(point))
+    {
+        out << pointReader.getError();
+        return out.str();
+    }
+
+    Counter counter(std::move(pointReader), out);
+    counter.count();
+    counter.printResult();
+    return out.str();
+}
+
+void Sweep::run()
+{
+    TimeProfiler t_sweep("time sweep");
+    const std::vector<CountPoint> points = reader.getSweepPoints();
+    // точки копируют колоду без линии инжекции, свою линию каждая строит заново
+    InputReader base(reader);
+    base.clearLine();
+
+    // без threads в колоде точки считаются на всех ядрах, если точек меньше потоков,
+    // оставшиеся потоки делят частицы внутри точки
+    const uint total = Parallel::threads(reader.isThreadsSet() ? reader.getThreads() : 0);
+    const uint nThreads = std::min<uint>(total, points.size());
+    const uint pointThreads = std::max<uint>(1, total / nThreads);
+
+    os << "# sweep points=" << points.size() << "\n";
+    // готовые результаты ждут, пока не записаны все точки перед ними
+    std::mutex mutex;
+    std::vector<std::string> results(points.size());
+    std::vector<char> done(points.size(), 0);
+    uint next = 0;
+    Parallel::run(points.size(), nThreads, [&](uint ipoint, uint) {
+        std::string result = runPoint(base, ipoint, points[ipoint], pointThreads);
+        std::lock_guard<std::mutex> lock(mutex);
+        results[ipoint] = std::move(result);
+        done[ipoint] = 1;
+        for (; next < points.size() && done[next]; next++)
+        {
+            os << "#\n" << results[next];
+            results[next] = std::string();
+        }
+    });
+}
@@ -0,0 +1,47 @@
+#include "TextWriter.h"
+
+#include <cstdio>
+#include <cstring>
+
+TextWriter & TextWriter::operator<<(const char *s)
+{
+    return write(s, std::strlen(s));
+}
+
+TextWriter & TextWriter::operator<<(int value)
+{
+    if (value < 0)
+    {
+        *this << '-';
+        return *this << static_cast<unsigned long long>(-static_cast<long long>(value));
+    }
+    return *this << static_cast<unsigned long long>(value);
+}
+
+TextWriter & TextWriter::operator<<(unsigned long long value)
+{
+    char digits[20];
+    int n = 0;
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    reserve(n);
+    while (n > 0)
+        buffer.push_back(digits[--n]);
+    return *this;
+}
+
+TextWriter & TextWriter::operator<<(double value)
+{
+    // мантисса precision+1 цифр, знак, точка и порядок до e-308 помещаются в 32 + precision
+    const size_t size = 32 + precision;
+    reserve(size);
+    const size_t used = buffer.size();
+    buffer.resize(used + size);
+    const int n = std::snprintf(buffer.data() + used, size, "%.*e", precision, value);
+    buffer.resize(used + (n > 0 ? n : 0));
+    return *this;
+}
@@ -1,14 +1,509 @@
 #include "TimeProfiler.h"
 
-std::map<std::string, double> TimeProfiler::timings;
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <limits>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+
+const unsigned TimeProfiler::Stats::SUB;
+const unsigned TimeProfiler::Stats::BUCKETS;
+
+struct TimeProfiler::Node
+{
+    std::string name;
+    Node *parent;
+    unsigned depth;
+    std::map<std::string, std::unique_ptr<Node>> children;
+    std::vector<Node *> order; // потомки в порядке первого входа
+    std::map<unsigned, Stats> threads; // по номеру потока в пуле Parallel::run
+    // счетчики perf потоков Parallel::run, запущенных внутри блока, кроме вызвавшего потока:
+    // их работа идет во время блока, но не попадает в его приращения в вызвавшем потоке
+    uint64_t workers[PerfCounters::N_EVENTS];
+};
+
+namespace {
+
+// блок на временной шкале, время в нс от начала процесса
+struct TraceEvent
+{
+    const TimeProfiler::Node *node;
+    double start;
+    double duration;
+    unsigned tid;
+    unsigned thread;
+    TimeProfiler::Tags tags;
+};
+
+// длительности и события трассы, накопленные потоком, до слияния в дерево
+struct Buffer
+{
+    std::map<std::pair<TimeProfiler::Node *, unsigned>, TimeProfiler::Stats> stats;
+    std::vector<TraceEvent> events;
+
+    void merge();
+    ~Buffer() { merge(); }
+};
+
+TimeProfiler::Node root{"", nullptr, 0, {}, {}, {}, {}};
+std::mutex mutex;
+
+std::vector<TraceEvent> trace;
+std::atomic<bool> tracing(false);
+std::atomic<bool> counting(false);
+std::vector<bool> tracks; // занятые дорожки трассы
+const TimeProfiler::Clock::time_point epoch = TimeProfiler::Clock::now();
+
+// узлы дерева, уже найденные потоком: потомки по родителю и имени; reset меняет поколение и кэши сбрасываются
+std::atomic<unsigned> generation(0);
+thread_local unsigned cacheGeneration = 0;
+thread_local std::unordered_map<const TimeProfiler::Node *, std::unordered_map<std::string, TimeProfiler::Node *>> children;
+
+thread_local TimeProfiler::Node *current = &root;
+thread_local unsigned thread = 0;
+thread_local TimeProfiler::Tags tags;
+
+// дорожка трассы потока: наименьший свободный номер, освобождается при выходе потока, поэтому
+// потоки следующих Parallel::run пишутся на те же дорожки, а одновременные потоки - на разные
+struct Track
+{
+    unsigned tid;
+
+    Track()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tid = std::find(tracks.begin(), tracks.end(), false) - tracks.begin();
+        if (tid == tracks.size())
+            tracks.push_back(true);
+        else
+            tracks[tid] = true;
+    }
+    ~Track()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tracks[tid] = false;
+    }
+};
+thread_local Track track;
+thread_local Buffer buffer;
+
+void Buffer::merge()
+{
+    if (stats.empty() && events.empty())
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto & it : stats)
+        it.first.first->threads[it.first.second].merge(it.second);
+    stats.clear();
+    trace.insert(trace.end(), std::make_move_iterator(events.begin()), std::make_move_iterator(events.end()));
+    events.clear();
+}
+
+void writeString(std::ostream &os, const std::string &s)
+{
+    os << '"';
+    for (const char c : s)
+    {
+        if (c == '"' || c == '\\')
+            os << '\\';
+        os << c;
+    }
+    os << '"';
+}
+
+unsigned bucket(double ns)
+{
+    if (ns < 1.)
+        return 0;
+    int e;
+    const double m = std::frexp(ns, &e); // ns = m*2^e, m в [0.5, 1)
+    const unsigned i = (e - 1)*TimeProfiler::Stats::SUB + static_cast<unsigned>((2.*m - 1.)*TimeProfiler::Stats::SUB);
+    return std::min(i, TimeProfiler::Stats::BUCKETS - 1);
+}
+
+void printStats(std::ostream &os, const std::string &name, const TimeProfiler::Stats &stats)
+{
+    os << "# " << std::setw(36) << std::left << name << std::right << std::setw(8) << stats.calls;
+    if (stats.calls == 0)
+    {
+        os << "\n";
+        return;
+    }
+    const double ms = 1e-6;
+    os << std::setw(12) << stats.total*ms << std::setw(12) << stats.total / stats.calls*ms
+       << std::setw(12) << stats.min*ms << std::setw(12) << stats.max*ms
+       << std::setw(12) << stats.quantile(0.5)*ms << std::setw(12) << stats.quantile(0.99)*ms;
+    if (AllocStats::enabled())
+    {
+        const double mb = 1. / (1 << 20);
+        os << std::setw(12) << stats.allocs << std::setw(12) << stats.allocBytes*mb
+           << std::setw(12) << stats.peakRss*mb << std::setw(12) << stats.rssGrowth*mb;
+    }
+    os << "\n";
+}
+
+// счетчики потоков Parallel::run в блоке node и во всех вложенных
+void addWorkers(const TimeProfiler::Node &node, uint64_t *c)
+{
+    for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+        c[i] += node.workers[i];
+    for (const TimeProfiler::Node *child : node.order)
+        addWorkers(*child, c);
+}
+
+void printCounterRow(std::ostream &os, const TimeProfiler::Node &node)
+{
+    TimeProfiler::Stats total;
+    for (const auto & it : node.threads)
+        total.merge(it.second);
+    addWorkers(node, total.counters);
+    const std::string indent(2*(node.depth - 1), ' ');
+    os << "# " << std::setw(36) << std::left << indent + node.name << std::right;
+
+    const uint64_t *c = total.counters;
+    for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+    {
+        if (PerfCounters::available(static_cast<PerfCounters::Event>(i)))
+            os << std::setw(15) << c[i];
+        else
+            os << std::setw(15) << "-";
+    }
+    const bool ipc = PerfCounters::available(PerfCounters::CYCLES) && PerfCounters::available(PerfCounters::INSTRUCTIONS) && c[PerfCounters::CYCLES] > 0;
+    if (ipc)
+        os << std::setw(8) << static_cast<double>(c[PerfCounters::INSTRUCTIONS]) / c[PerfCounters::CYCLES];
+    else
+        os << std::setw(8) << "-";
+
+    // на единицу работы: циклы, промахи кэша и переходов
+    if (total.units > 0.)
+    {
+        os << "  per " << total.unit << ":";
+        const PerfCounters::Event perUnit[] = {PerfCounters::CYCLES, PerfCounters::CACHE_MISSES, PerfCounters::BRANCH_MISSES};
+        for (const PerfCounters::Event e : perUnit)
+        {
+            if (PerfCounters::available(e))
+                os << " " << PerfCounters::name(e) << "=" << c[e] / total.units;
+        }
+    }
+    os << "\n";
+
+    for (const TimeProfiler::Node *child : node.order)
+        printCounterRow(os, *child);
+}
+
+void printCounters(std::ostream &os)
+{
+    os << "#\n# === Hardware Counters (perf_event, user space) ===\n";
+    bool any = false;
+    for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+        any = any || PerfCounters::available(static_cast<PerfCounters::Event>(i));
+    if (!any)
+    {
+        os << "# счетчики недоступны: " << PerfCounters::error() << "\n";
+        return;
+    }
+
+    os << "# " << std::setw(36) << std::left << "scope" << std::right;
+    for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+        os << std::setw(15) << PerfCounters::name(static_cast<PerfCounters::Event>(i));
+    os << std::setw(8) << "IPC" << "\n";
+    for (const TimeProfiler::Node *child : root.order)
+        printCounterRow(os, *child);
+}
+
+void printNode(std::ostream &os, const TimeProfiler::Node &node)
+{
+    const std::string indent(2*(node.depth - 1), ' ');
+    TimeProfiler::Stats total;
+    for (const auto & it : node.threads)
+        total.merge(it.second);
+    printStats(os, indent + node.name, total);
+    if (node.threads.size() > 1)
+    {
+        for (const auto & it : node.threads)
+            printStats(os, indent + "  [slot " + std::to_string(it.first) + "]", it.second);
+    }
+
+    for (const TimeProfiler::Node *child : node.order)
+        printNode(os, *child);
+}
+
+}
+
+void TimeProfiler::Stats::add(double ns)
+{
+    min = calls == 0 ? ns : std::min(min, ns);
+    max = std::max(max, ns);
+    calls++;
+    total += ns;
+    if (histogram.empty())
+        histogram.assign(BUCKETS, 0);
+    histogram[bucket(ns)]++;
+}
+
+void TimeProfiler::Stats::merge(const Stats &other)
+{
+    if (other.calls == 0 && other.units == 0.)
+        return;
+    if (other.calls > 0)
+        min = calls == 0 ? other.min : std::min(min, other.min);
+    max = std::max(max, other.max);
+    calls += other.calls;
+    total += other.total;
+    for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+        counters[i] += other.counters[i];
+    units += other.units;
+    if (other.unit)
+        unit = other.unit;
+    allocs += other.allocs;
+    allocBytes += other.allocBytes;
+    peakRss = std::max(peakRss, other.peakRss);
+    rssGrowth += other.rssGrowth;
+    // у блока только с addUnits вызовов нет и гистограмма пустая
+    if (other.histogram.empty())
+        return;
+    if (histogram.empty())
+        histogram.assign(BUCKETS, 0);
+    for (unsigned i = 0; i < BUCKETS; i++)
+        histogram[i] += other.histogram[i];
+}
+
+double TimeProfiler::Stats::quantile(double q) const
+{
+    if (calls == 0)
+        return 0.;
+    // середина корзины, в которую попадает вызов номер ceil(q*calls)
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q*calls)));
+    uint64_t seen = 0;
+    unsigned i = 0;
+    for (; i + 1 < BUCKETS; i++)
+    {
+        seen += histogram[i];
+        if (seen >= rank)
+            break;
+    }
+    const double value = std::ldexp(1. + (i % SUB + 0.5) / SUB, i / SUB);
+    return std::min(max, std::max(min, value));
+}
+
+TimeProfiler::Worker::Worker(const Context &context, unsigned ithread) : saved(current), savedThread(thread), savedTags(tags),
+    node(context.node), counted(false)
+{
+    current = context.node;
+    thread = ithread;
+    tags = context.tags;
+    // поток 0 - сам вызвавший поток, его счетчики уже идут в открытый блок
+    counted = ithread > 0 && counting.load(std::memory_order_relaxed);
+    if (counted)
+        PerfCounters::read(startCounters);
+}
+
+TimeProfiler::Worker::~Worker()
+{
+    if (counted)
+    {
+        PerfCounters::Values end;
+        PerfCounters::read(end);
+        uint64_t delta[PerfCounters::N_EVENTS];
+        PerfCounters::delta(startCounters, end, delta);
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+            node->workers[i] += delta[i];
+    }
+    current = saved;
+    thread = savedThread;
+    tags = savedTags;
+}
+
+TimeProfiler::Tag::Tag(const char *key, long long value)
+{
+    tags.emplace_back(key, value);
+}
+
+TimeProfiler::Tag::~Tag()
+{
+    tags.pop_back();
+}
+
+TimeProfiler::TimeProfiler(const std::string& name) : parent(current)
+{
+    // потомки ищутся в кэше потока, общее дерево блокируется только при первом входе потока в блок
+    if (cacheGeneration != generation.load(std::memory_order_acquire))
+    {
+        children.clear();
+        cacheGeneration = generation.load(std::memory_order_acquire);
+    }
+    std::unordered_map<std::string, Node *> &cached = children[parent];
+    const auto it = cached.find(name);
+    if (it != cached.end())
+        node = it->second;
+    else
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unique_ptr<Node> &child = parent->children[name];
+        if (!child)
+        {
+            child.reset(new Node{name, parent, parent->depth + 1, {}, {}, {}, {}});
+            parent->order.push_back(child.get());
+        }
+        node = child.get();
+        cached.emplace(name, node);
+    }
+    current = node;
+    if (AllocStats::enabled())
+    {
+        startRss = AllocStats::peakRss();
+        startAlloc = AllocStats::thread();
+    }
+    counted = counting.load(std::memory_order_relaxed);
+    if (counted)
+        PerfCounters::read(startCounters);
+    start = Clock::now();
+}
+
+TimeProfiler::~TimeProfiler()
+{
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    // выделения самого профилировщика в буфере не попадают в блок
+    const AllocStats endAlloc = AllocStats::thread();
+    Stats &stats = buffer.stats[std::make_pair(node, thread)];
+    stats.add(ns);
+    if (AllocStats::enabled())
+    {
+        const double rss = AllocStats::peakRss();
+        stats.allocs += endAlloc.count - startAlloc.count;
+        stats.allocBytes += endAlloc.bytes - startAlloc.bytes;
+        stats.peakRss = std::max(stats.peakRss, rss);
+        stats.rssGrowth += rss - startRss;
+    }
+    if (counted)
+    {
+        PerfCounters::Values end;
+        PerfCounters::read(end);
+        uint64_t delta[PerfCounters::N_EVENTS];
+        PerfCounters::delta(startCounters, end, delta);
+        for (int i = 0; i < PerfCounters::N_EVENTS; i++)
+            stats.counters[i] += delta[i];
+    }
+    if (tracing.load(std::memory_order_relaxed))
+    {
+        const double begin = std::chrono::duration<double, std::nano>(start - epoch).count();
+        buffer.events.push_back(TraceEvent{node, begin, ns, track.tid, thread, tags});
+    }
+    current = parent;
+}
+
+TimeProfiler::Context TimeProfiler::context()
+{
+    return Context{current, tags};
+}
 
 void TimeProfiler::print(std::ostream &os)
 {
-        os << "\n# === Time Profiling Results (ms) ===\n";
-        os << std::fixed << std::setprecision(3);  // 3 знака после запятой
-        for (const auto& it : timings) {
-            os << "# " << std::setw(25) << std::left << it.first
-                      << ": " << std::setw(10) << std::right << it.second << " ms\n";
+    // потоки Parallel::run уже завершились и слили свои буферы, остается текущий
+    buffer.merge();
+    std::lock_guard<std::mutex> lock(mutex);
+    os << "\n# === Time Profiling Results (ms) ===\n";
+    os << "# " << std::setw(36) << std::left << "scope" << std::right << std::setw(8) << "calls"
+       << std::setw(12) << "total" << std::setw(12) << "mean" << std::setw(12) << "min"
+       << std::setw(12) << "max" << std::setw(12) << "p50" << std::setw(12) << "p99";
+    // выделения потока блока и пиковый RSS процесса, МБ
+    if (AllocStats::enabled())
+        os << std::setw(12) << "allocs" << std::setw(12) << "alloc MB" << std::setw(12) << "peak MB" << std::setw(12) << "+peak MB";
+    os << "\n";
+    os << std::fixed << std::setprecision(3);  // 3 знака после запятой
+    for (const Node *child : root.order)
+        printNode(os, *child);
+    if (counting)
+        printCounters(os);
+    os << std::resetiosflags(std::ios::fixed);  // Сброс форматирования
+}
+
+void TimeProfiler::reset()
+{
+    buffer.stats.clear();
+    buffer.events.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    root.children.clear();
+    root.order.clear();
+    generation++;
+    children.clear();
+    std::fill(root.workers, root.workers + PerfCounters::N_EVENTS, 0);
+    trace.clear();
+}
+
+bool TimeProfiler::enableCounters()
+{
+    counting = true;
+    return PerfCounters::probe();
+}
+
+void TimeProfiler::disableCounters()
+{
+    counting = false;
+}
+
+void TimeProfiler::addUnits(double n, const char *unit)
+{
+    Stats &stats = buffer.stats[std::make_pair(current, thread)];
+    stats.units += n;
+    stats.unit = unit;
+}
+
+void TimeProfiler::enableTrace()
+{
+    tracing = true;
+}
+
+void TimeProfiler::disableTrace()
+{
+    tracing = false;
+    buffer.events.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    trace.clear();
+}
+
+bool TimeProfiler::isTracing()
+{
+    return tracing;
+}
+
+bool TimeProfiler::writeTrace(const std::string &path)
+{
+    buffer.merge();
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream fout(path);
+    if (!fout.is_open())
+        return false;
+
+    std::sort(trace.begin(), trace.end(), [](const TraceEvent &a, const TraceEvent &b) {
+        return a.start < b.start || (a.start == b.start && a.duration > b.duration);
+    });
+
+    // ts и dur в микросекундах
+    fout << std::fixed << std::setprecision(3);
+    fout << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    fout << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"capture\"}}";
+    for (const TraceEvent & event : trace)
+    {
+        fout << ",\n{\"name\":";
+        writeString(fout, event.node->name);
+        fout << ",\"cat\":\"scope\",\"ph\":\"X\",\"ts\":" << event.start*1e-3 << ",\"dur\":" << event.duration*1e-3
+             << ",\"pid\":1,\"tid\":" << event.tid << ",\"args\":{\"thread\":" << event.thread;
+        // у вложенных одноименных меток (job внутри job) пишется внутренняя
+        for (size_t i = 0; i < event.tags.size(); i++)
+        {
+            bool inner = true;
+            for (size_t j = i + 1; j < event.tags.size(); j++)
+                inner = inner && std::strcmp(event.tags[i].first, event.tags[j].first) != 0;
+            if (inner)
+                fout << ",\"" << event.tags[i].first << "\":" << event.tags[i].second;
         }
-        os << std::resetiosflags(std::ios::fixed);  // Сброс форматирования
-}
\ No newline at end of file
+        fout << "}}";
+    }
+    fout << "\n]}\n";
+    return static_cast<bool>(fout);
+}
@@ -3,16 +3,41 @@
 #include <random>
 #include <vector>
 #include "Counter.h"
+#include "Sweep.h"
+#include "Injectors.h"
+#include "ResultFile.h"
 
 int main(int argc, char** argv)
 {
+    // capture result.bin - печать двоичного результата текстом
+    if (argc > 1)
+    {
+        ResultFile result;
+        std::string error;
+        if (!result.open(argv[1], error))
+        {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        result.print(std::cout);
+        return 0;
+    }
 
     std::ifstream fin("../test.in");
     std::ofstream fout("../test.out");
 
     if (fin.is_open() && fout.is_open())
     {
+        // trace= и perf= известны только после чтения колоды, а в трассу и счетчики должны попасть
+        // и чтение, и линия инжекции: профилировщик пишет все с самого начала, ненужное отбрасывается;
+        // недоступные счетчики не ошибка, профиль напишет причину
+        TimeProfiler::enableTrace();
+        TimeProfiler::enableCounters();
         Counter counter(fin, fout);
+        if (counter.getReader().getTracePath().empty() || !counter.isReadSuccess())
+            TimeProfiler::disableTrace();
+        if (!counter.getReader().isPerfCounters())
+            TimeProfiler::disableCounters();
         if (!counter.isReadSuccess()) {
             std::cerr << counter.getReader().getError();
             fin.close();
@@ -20,8 +45,25 @@ int main(int argc, char** argv)
             return 1;
         }
         counter.printStartInfo();
-        counter.count();
-        counter.printResult();
+        if (counter.getReader().hasSweep() || !counter.getReader().getInjectors().empty())
+            counter.syncOutput();
+        if (counter.getReader().hasSweep())
+        {
+            Sweep sweep(counter.getReader(), counter.getSeed(), fout);
+            sweep.run();
+        }
+        else if (!counter.getReader().getInjectors().empty())
+        {
+            Injectors injectors(counter.getReader(), counter.getSeed(), fout);
+            injectors.run();
+        }
+        else
+        {
+            counter.count();
+            counter.printResult();
+            if (!counter.getReader().getBinaryPath().empty() && !counter.writeBinary())
+                std::cerr << "не удалось записать " << counter.getReader().getBinaryPath() << "\n";
+        }
     }
     fin.close();
     fout.close();